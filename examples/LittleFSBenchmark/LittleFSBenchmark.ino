@@ -0,0 +1,77 @@
+#include <SerialRAM.h>
+#include <SerialRAMLittleFS.h>
+
+//Requires the littlefs library (lfs.h). Measures file create, append and read throughput on two chips.
+
+SerialRAM ram0;
+SerialRAM ram1;
+SerialRAMLittleFS bank;
+lfs_t lfs;
+struct lfs_config config;
+
+uint8_t record[32];
+
+void report(const char* label, unsigned long bytes, unsigned long elapsed) {
+  Serial.print(label);
+  Serial.print(": ");
+  Serial.print(bytes);
+  Serial.print(" bytes in ");
+  Serial.print(elapsed);
+  Serial.print(" ms - ");
+  Serial.print(elapsed ? bytes * 1000UL / elapsed : 0);
+  Serial.println(" B/s");
+}
+
+void setup() {
+  Serial.begin(115200);
+  ram0.begin(0, 0);
+  ram1.begin(0, 1);
+  bank.add(ram0);
+  bank.add(ram1);
+  bank.configure(&config);
+
+  lfs_format(&lfs, &config);
+  lfs_mount(&lfs, &config);
+
+  for(uint8_t i = 0; i < sizeof(record); i++) {
+    record[i] = i;
+  }
+
+  //create: 16 small files
+  unsigned long start = millis();
+  char name[8] = "file00";
+  for(uint8_t i = 0; i < 16; i++) {
+    lfs_file_t file;
+    name[4] = '0' + i / 10;
+    name[5] = '0' + i % 10;
+    lfs_file_open(&lfs, &file, name, LFS_O_WRONLY | LFS_O_CREAT);
+    lfs_file_write(&lfs, &file, record, sizeof(record));
+    lfs_file_close(&lfs, &file);
+  }
+  report("create", 16UL * sizeof(record), millis() - start);
+
+  //append: one growing log file
+  start = millis();
+  lfs_file_t log;
+  lfs_file_open(&lfs, &log, "log", LFS_O_WRONLY | LFS_O_CREAT | LFS_O_APPEND);
+  for(uint8_t i = 0; i < 32; i++) {
+    lfs_file_write(&lfs, &log, record, sizeof(record));
+  }
+  lfs_file_close(&lfs, &log);
+  report("append", 32UL * sizeof(record), millis() - start);
+
+  //read: the log file back
+  start = millis();
+  unsigned long total = 0;
+  lfs_file_open(&lfs, &log, "log", LFS_O_RDONLY);
+  while(lfs_file_read(&lfs, &log, record, sizeof(record)) > 0) {
+    total += sizeof(record);
+  }
+  lfs_file_close(&lfs, &log);
+  report("read", total, millis() - start);
+
+  lfs_unmount(&lfs);
+}
+
+void loop() {
+}
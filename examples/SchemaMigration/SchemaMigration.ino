@@ -0,0 +1,36 @@
+#include <SerialRAM.h>
+#include <SerialRAMSchema.h>
+
+
+SerialRAM ram;
+SerialRAMSchema schema(ram);
+
+//version 1 layout: [counter:2][threshold:2]
+//version 2 layout: [counter:2][flags:1][threshold:2]
+const SerialRAMMigrationOp v1ToV2[] = {
+  { SERIALRAM_OP_MOVE, 3, 2, 2 }, //shift threshold up by one byte
+  { SERIALRAM_OP_FILL, 2, 0x00, 1 } //clear the new flags byte
+};
+
+const SerialRAMMigration migrations[] = {
+  { 1, v1ToV2, 2 }
+};
+
+void setup() {
+  Serial.begin(115200);
+  ram.begin();
+
+  uint8_t status = schema.begin(2, migrations, 1);
+
+  Serial.print("Stored layout version: 0x");
+  Serial.print(schema.getStoredVersion(), HEX);
+  Serial.print(" - status: ");
+  Serial.println(status);
+}
+
+void loop() {
+  uint16_t data = schema.dataAddress();
+  ram.write(data + 2, 0x01);
+
+  delay(1000);
+}
@@ -0,0 +1,53 @@
+/*
+	CacheStreamTest.cpp
+	Host test: a streamed scan through a SerialRAMCache does not evict the hot lines, whatever the replacement policy
+
+	Build and run from this folder, once per policy (0 round robin, 1 LRU, 2 CLOCK):
+		g++ -DARDUINO=100 -DSERIALRAM_CACHE_LINES=4 -DSERIALRAM_CACHE_POLICY=1 -I. -I../../src Wire.cpp CacheStreamTest.cpp ../../src/SerialRAM*.cpp -o CacheStreamTest && ./CacheStreamTest
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#include <stdio.h>
+#include "Wire.h"
+#include "SerialRAM.h"
+#include "SerialRAMCache.h"
+
+//hot lines are all the lines but one, which is left to the scan
+#define HOT_LINES (SERIALRAM_CACHE_LINES - 1)
+
+static void touchHotSet(SerialRAMCache& cache) {
+	for(uint16_t address = 0; address < HOT_LINES * SERIALRAM_CHUNK_SIZE; address++) {
+		(void)(uint8_t)cache[address];
+	}
+}
+
+int main() {
+	for(uint16_t address = 0; address < sizeof(simulatedMemory); address++) {
+		simulatedMemory[address] = (uint8_t)address;
+	}
+	SerialRAM ram;
+	ram.begin();
+	SerialRAMCache cache(ram);
+	touchHotSet(cache);
+	touchHotSet(cache);
+
+	//scan the rest of the chip byte by byte, hitting every streamed line many times
+	cache.setStreaming(true);
+	for(uint16_t address = 512; address < sizeof(simulatedMemory); address++) {
+		(void)(uint8_t)cache[address];
+	}
+	cache.setStreaming(false);
+
+	cache.resetStatistics();
+	touchHotSet(cache);
+	SerialRAMCacheStats stats = cache.getStatistics();
+	if(stats.misses || cache.getStatus()) {
+		printf("FAIL: policy %d, %lu misses on the hot set after the scan\n", SERIALRAM_CACHE_POLICY, (unsigned long)stats.misses);
+		return 1;
+	}
+	printf("OK: policy %d, hot set kept through the scan\n", SERIALRAM_CACHE_POLICY);
+	return 0;
+}
@@ -0,0 +1,140 @@
+/*
+	LogCompactionTest.cpp
+	Host test: a SerialRAMLog compaction pass interrupted by a power loss at any written byte, or by a NACK at any transfer,
+	keeps every live record readable, before and after the log is opened again
+
+	Build and run from this folder:
+		g++ -DARDUINO=100 -I. -I../../src Wire.cpp LogCompactionTest.cpp ../../src/SerialRAM*.cpp -o LogCompactionTest && ./LogCompactionTest
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#include <stdio.h>
+#include "Wire.h"
+#include "SerialRAM.h"
+#include "SerialRAMLog.h"
+
+#define LOG_ADDRESS 64
+#define LOG_SIZE 400
+
+static uint8_t prepared[sizeof(simulatedMemory)];
+static uint8_t small[3] = { 1, 2, 3 };
+static uint8_t large[40];
+
+//Records k0, k0, k1, k2, then k3 after a removed k4: compaction slides k1 and k2 across narrow gaps and k3 across a wide one
+static void prepare() {
+	memset(simulatedMemory, 0, sizeof(simulatedMemory));
+	for(uint8_t i = 0; i < sizeof(large); i++) {
+		large[i] = 100 + i;
+	}
+	SerialRAM ram;
+	ram.begin();
+	SerialRAMLog log(ram, LOG_ADDRESS, LOG_SIZE);
+	log.begin();
+	log.clear();
+	log.append(0, small, 1);
+	log.append(0, small, 2);
+	log.append(1, large, sizeof(large));
+	log.append(2, small, 3);
+	log.append(4, large, 30);
+	log.remove(4);
+	log.append(3, large, 20);
+	memcpy(prepared, simulatedMemory, sizeof(prepared));
+}
+
+static bool holds(SerialRAMLog& log, const uint8_t key, const uint8_t* expected, const uint8_t size) {
+	uint8_t values[64];
+	uint8_t length;
+	return !log.read(key, values, sizeof(values), &length) && length == size && !memcmp(values, expected, size);
+}
+
+static bool intact(SerialRAMLog& log) {
+	uint8_t values[64];
+	uint8_t length;
+	return holds(log, 0, small, 2) && holds(log, 1, large, sizeof(large)) && holds(log, 2, small, 3) && holds(log, 3, large, 20)
+		&& log.read(4, values, sizeof(values), &length) == 6;
+}
+
+//Finish the pass, retrying after errors, then check the log as it is and once opened again
+static bool finishAndCheck(SerialRAMLog& log) {
+	for(uint16_t tries = 0; log.isCompacting() && tries < 1000; tries++) {
+		log.compactStep(8);
+	}
+	if(log.isCompacting() || !intact(log)) {
+		return false;
+	}
+	SerialRAM ram;
+	ram.begin();
+	SerialRAMLog reopened(ram, LOG_ADDRESS, LOG_SIZE);
+	return !reopened.begin() && intact(reopened) && !reopened.garbage();
+}
+
+int main() {
+	prepare();
+	long powerLosses = 0;
+	for(long budget = 0; ; budget++) {
+		memcpy(simulatedMemory, prepared, sizeof(simulatedMemory));
+		bool interrupted = false;
+		{
+			SerialRAM ram;
+			ram.begin();
+			SerialRAMLog log(ram, LOG_ADDRESS, LOG_SIZE);
+			log.begin();
+			log.compact();
+			simulatedWriteBudget = budget;
+			try {
+				while(log.isCompacting()) {
+					log.compactStep(8);
+				}
+			} catch(SimulatedPowerLoss&) {
+				interrupted = true;
+			}
+			simulatedWriteBudget = -1;
+		}
+		SerialRAM ram;
+		ram.begin();
+		SerialRAMLog log(ram, LOG_ADDRESS, LOG_SIZE);
+		if(log.begin() || !intact(log)) {
+			printf("FAIL: power loss after %ld bytes\n", budget);
+			return 1;
+		}
+		log.compact();
+		if(!finishAndCheck(log)) {
+			printf("FAIL: power loss after %ld bytes, compaction did not recover\n", budget);
+			return 1;
+		}
+		if(!interrupted) {
+			break;
+		}
+		powerLosses++;
+	}
+
+	long nacks = 0;
+	for(long transfer = 0; ; transfer++) {
+		memcpy(simulatedMemory, prepared, sizeof(simulatedMemory));
+		SerialRAM ram;
+		ram.begin();
+		SerialRAMLog log(ram, LOG_ADDRESS, LOG_SIZE);
+		log.begin();
+		log.compact();
+		simulatedNackCountdown = transfer;
+		bool failed = false;
+		while(log.isCompacting() && !failed) {
+			failed = log.compactStep(8) != 0;
+		}
+		bool nacked = simulatedNackCountdown < 0;
+		simulatedNackCountdown = -1;
+		if(!finishAndCheck(log)) {
+			printf("FAIL: NACK at transfer %ld\n", transfer);
+			return 1;
+		}
+		if(!nacked) {
+			break;
+		}
+		nacks++;
+	}
+	printf("OK: %ld power losses and %ld NACKs during compaction, every live record kept\n", powerLosses, nacks);
+	return 0;
+}
@@ -0,0 +1,89 @@
+/*
+	SchemaResumeTest.cpp
+	Host test: a migration interrupted by a power loss at any written byte resumes to the same layout as an uninterrupted one
+
+	Build and run from this folder:
+		g++ -DARDUINO=100 -I. -I../../src Wire.cpp SchemaResumeTest.cpp ../../src/SerialRAM*.cpp -o SchemaResumeTest && ./SchemaResumeTest
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#include <stdio.h>
+#include "Wire.h"
+#include "SerialRAM.h"
+#include "SerialRAMSchema.h"
+
+#define LAYOUT_SIZE 48
+
+//version 1 -> 2: shift everything up by 3 bytes, overlapping, and clear the 3 new bytes
+const SerialRAMMigrationOp v1ToV2[] = {
+	{ SERIALRAM_OP_MOVE, 3, 0, 40 },
+	{ SERIALRAM_OP_FILL, 0, 0x00, 3 }
+};
+
+//version 2 -> 3: drop 5 bytes at the front, overlapping the other way
+const SerialRAMMigrationOp v2ToV3[] = {
+	{ SERIALRAM_OP_MOVE, 0, 5, 38 },
+	{ SERIALRAM_OP_FILL, 38, 0xee, 10 }
+};
+
+const SerialRAMMigration migrations[] = {
+	{ 1, v1ToV2, 2 },
+	{ 2, v2ToV3, 2 }
+};
+
+//Stamp a chip with layout version 1 holding a recognizable pattern
+static void prepare() {
+	memset(simulatedMemory, 0xff, sizeof(simulatedMemory));
+	SerialRAM ram;
+	ram.begin();
+	SerialRAMSchema schema(ram);
+	schema.begin(1);
+	for(uint8_t i = 0; i < LAYOUT_SIZE; i++) {
+		ram.write(schema.dataAddress() + i, (uint8_t)(i + 1));
+	}
+}
+
+//Migrate to version 3 with a fresh SerialRAM, as after a reset
+static uint8_t migrate() {
+	SerialRAM ram;
+	ram.begin();
+	SerialRAMSchema schema(ram);
+	return schema.begin(3, migrations, 2);
+}
+
+int main() {
+	uint8_t expected[LAYOUT_SIZE];
+	prepare();
+	if(migrate()) {
+		printf("FAIL: uninterrupted migration\n");
+		return 1;
+	}
+	memcpy(expected, simulatedMemory + SERIALRAM_SCHEMA_HEADER_SIZE, LAYOUT_SIZE);
+
+	long interruptions = 0;
+	for(long budget = 0; ; budget++) {
+		prepare();
+		bool interrupted = false;
+		simulatedWriteBudget = budget;
+		try {
+			migrate();
+		} catch(SimulatedPowerLoss&) {
+			interrupted = true;
+		}
+		simulatedWriteBudget = -1;
+		if(!interrupted) {
+			break;
+		}
+		interruptions++;
+		uint8_t status = migrate();
+		if(status || memcmp(expected, simulatedMemory + SERIALRAM_SCHEMA_HEADER_SIZE, LAYOUT_SIZE)) {
+			printf("FAIL: power loss after %ld bytes, resumed with status %d\n", budget, status);
+			return 1;
+		}
+	}
+	printf("OK: %ld interruption points resumed to the expected layout\n", interruptions);
+	return 0;
+}
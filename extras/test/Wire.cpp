@@ -0,0 +1,102 @@
+/*
+	Wire.cpp
+	Host stand-in for the Arduino Wire library, backed by a simulated 47x16 chip, for the tests in extras/test
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#include "Wire.h"
+
+uint8_t simulatedMemory[2048];
+long simulatedWriteBudget = -1;
+long simulatedNackCountdown = -1;
+TwoWire Wire;
+
+unsigned long micros() {
+	return 0;
+}
+
+unsigned long millis() {
+	return 0;
+}
+
+void TwoWire::begin() {
+}
+
+void TwoWire::beginTransmission(uint8_t address) {
+	this->device = address;
+	this->transmitted = 0;
+}
+
+void TwoWire::beginTransmission(int address) {
+	this->beginTransmission((uint8_t)address);
+}
+
+//The SRAM answers at 0x50-0x53, the first two bytes set the address pointer and the next ones are stored one by one
+uint8_t TwoWire::endTransmission(uint8_t stop) {
+	if((this->device & 0xfc) != 0x50 || this->transmitted < 2) {
+		return 0;
+	}
+	if(simulatedNackCountdown == 0) {
+		simulatedNackCountdown = -1;
+		return 2;
+	}
+	if(simulatedNackCountdown > 0) {
+		simulatedNackCountdown--;
+	}
+	this->pointer = ((this->transmit[0] << 8) | this->transmit[1]) & 0x7ff;
+	for(uint8_t i = 2; i < this->transmitted; i++) {
+		if(simulatedWriteBudget == 0) {
+			throw SimulatedPowerLoss();
+		}
+		if(simulatedWriteBudget > 0) {
+			simulatedWriteBudget--;
+		}
+		simulatedMemory[this->pointer] = this->transmit[i];
+		this->pointer = (this->pointer + 1) & 0x7ff;
+	}
+	return 0;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, uint8_t stop) {
+	this->received = quantity > sizeof(this->receive) ? sizeof(this->receive) : quantity;
+	this->position = 0;
+	for(uint8_t i = 0; i < this->received; i++) {
+		this->receive[i] = (address & 0xfc) == 0x50 ? simulatedMemory[this->pointer] : 0;
+		this->pointer = (this->pointer + 1) & 0x7ff;
+	}
+	return this->received;
+}
+
+uint8_t TwoWire::requestFrom(int address, int quantity) {
+	return this->requestFrom((uint8_t)address, (uint8_t)quantity);
+}
+
+size_t TwoWire::write(uint8_t value) {
+	if(this->transmitted >= sizeof(this->transmit)) {
+		return 0;
+	}
+	this->transmit[this->transmitted++] = value;
+	return 1;
+}
+
+size_t TwoWire::write(const uint8_t* values, size_t size) {
+	for(size_t i = 0; i < size; i++) {
+		this->write(values[i]);
+	}
+	return size;
+}
+
+int TwoWire::available() {
+	return this->received - this->position;
+}
+
+int TwoWire::read() {
+	return this->position < this->received ? this->receive[this->position++] : -1;
+}
+
+int TwoWire::peek() {
+	return this->position < this->received ? this->receive[this->position] : -1;
+}
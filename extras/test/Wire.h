@@ -0,0 +1,52 @@
+/*
+	Wire.h
+	Host stand-in for the Arduino Wire library, backed by a simulated 47x16 chip, for the tests in extras/test
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#ifndef _SerialRAMTestWire_h
+#define _SerialRAMTestWire_h
+
+#include "arduino.h"
+
+//Contents of the simulated chip
+extern uint8_t simulatedMemory[2048];
+
+//Number of data bytes the chip still accepts before a simulated power loss, which throws SimulatedPowerLoss. -1 for no limit.
+extern long simulatedWriteBudget;
+
+struct SimulatedPowerLoss {};
+
+//Number of SRAM transmissions that still go through before one is answered with a NACK (status 2) and dropped. -1 for none.
+extern long simulatedNackCountdown;
+
+class TwoWire : public Stream {
+private:
+	uint8_t device;
+	uint8_t transmit[64];
+	uint8_t transmitted;
+	uint8_t receive[64];
+	uint8_t received;
+	uint8_t position;
+	uint16_t pointer;
+
+public:
+	void begin();
+	void beginTransmission(uint8_t address);
+	void beginTransmission(int address);
+	uint8_t endTransmission(uint8_t stop = true);
+	uint8_t requestFrom(uint8_t address, uint8_t quantity, uint8_t stop = true);
+	uint8_t requestFrom(int address, int quantity);
+	size_t write(uint8_t value);
+	size_t write(const uint8_t* values, size_t size);
+	int available();
+	int read();
+	int peek();
+};
+
+extern TwoWire Wire;
+
+#endif
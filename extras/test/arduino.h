@@ -0,0 +1,48 @@
+/*
+	arduino.h
+	Minimal host stand-in for the Arduino core, only what the library uses, for the tests in extras/test
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#ifndef _SerialRAMTestArduino_h
+#define _SerialRAMTestArduino_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+
+unsigned long micros();
+unsigned long millis();
+
+class Print {
+public:
+	virtual ~Print() {}
+	virtual size_t write(uint8_t value) = 0;
+	virtual size_t write(const uint8_t* values, size_t size) {
+		for(size_t i = 0; i < size; i++) {
+			this->write(values[i]);
+		}
+		return size;
+	}
+};
+
+class Stream : public Print {
+public:
+	virtual int available() = 0;
+	virtual int read() = 0;
+	virtual int peek() = 0;
+	void setTimeout(unsigned long timeout) {}
+	size_t readBytes(uint8_t* values, size_t size) {
+		size_t i = 0;
+		for(int c; i < size && (c = this->read()) >= 0; i++) {
+			values[i] = c;
+		}
+		return i;
+	}
+};
+
+#endif
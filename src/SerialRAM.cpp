@@ -14,26 +14,79 @@
 #include <stdint.h>
 #include <Wire.h>
 #include "SerialRAM.h"
+#include "SerialRAMAddress.h"
+#include "SerialRAMBus.h"
+
+//Index of the first byte equal to "value" in data[0, size), or size. Compares a 32 bit word at a time:
+//the word XOR the repeated value has a zero byte exactly where a byte matches.
+static uint8_t findByte(const uint8_t* data, const uint8_t size, const uint8_t value)
+{
+	uint32_t pattern = 0x01010101UL * value;
+	uint8_t i = 0;
+	for(; i + 4 <= size; i += 4) {
+		uint32_t word;
+		memcpy(&word, data + i, 4);
+		word ^= pattern;
+		if((word - 0x01010101UL) & ~word & 0x80808080UL) {
+			break;
+		}
+	}
+	for(; i < size; i++) {
+		if(data[i] == value) {
+			return i;
+		}
+	}
+	return size;
+}
 
 
+SerialRAM::SerialRAM() {
+	this->busy = false;
+	this->bus = 0;
+	this->wire = &Wire;
+}
+
 ///<summary>
 ///	Initialize the RAM chip with the given A0 and A1 values.
+///		The I2C peripheral is only initialized by the first chip using it, see serialRAMBeginWire().
 ///	<param name="A0">A0 value (logic 0 or 1) of the RAM chip you want to address. Default value 0.</param>
 ///	<param name="A1">A1 value (logic 0 or 1) of the RAM chip you want to address. Default value 0.</param>
 ///	<param name="SIZE">Size of the RAM chip you want to address in kbits (only 4 or 16 valid). Default value 16.</param>
 ///</summary>
 uint8_t SerialRAM::begin(const uint8_t A0, const uint8_t A1, const uint8_t SIZE) {
+	uint8_t status = this->configure(A0, A1, SIZE);
+
+	//Arduino I2C lib
+	serialRAMBeginWire(this->wire);
+
+	return status;
+}
+
+///<summary>
+///	Initialize the RAM chip wired to the I2C peripheral "wire", for boards with more than one bus.
+///	<param name="wire">I2C peripheral the chip is connected to</param>
+///	<param name="A0">A0 value (logic 0 or 1) of the RAM chip you want to address.</param>
+///	<param name="A1">A1 value (logic 0 or 1) of the RAM chip you want to address.</param>
+///	<param name="SIZE">Size of the RAM chip you want to address in kbits (only 4 or 16 valid).</param>
+///</summary>
+uint8_t SerialRAM::begin(TwoWire& wire, const uint8_t A0, const uint8_t A1, const uint8_t SIZE) {
+	this->wire = &wire;
+	return this->begin(A0, A1, SIZE);
+}
+
+///<summary>
+///	Same as begin() without touching the I2C peripheral, for chips brought up together by SerialRAMBus::begin().
+///</summary>
+uint8_t SerialRAM::configure(const uint8_t A0, const uint8_t A1, const uint8_t SIZE) {
 	//build mask
-	uint8_t mask = (A0 << 1) | (A1);
-	mask <<= 1;
+	uint8_t mask = serialRAMAddressMask(A0, A1);
 
 	//save registers addresses
-	this->SRAM_REGISTER = 0x50 | mask;
-	this->CONTROL_REGISTER = 0x18 | mask;
+	this->SRAM_REGISTER = SERIALRAM_SRAM_ADDRESS | mask;
+	this->CONTROL_REGISTER = SERIALRAM_CONTROL_ADDRESS | mask;
+
+	this->busy = false;
 
-	//Arduino I2C lib
-	Wire.begin();
-	
 	//check chip size variable
 	if(SIZE == 16){
 		this->STORAGE_ARRAY_SIZE = 0xf8;
@@ -49,6 +102,34 @@ uint8_t SerialRAM::begin(const uint8_t A0, const uint8_t A1, const uint8_t SIZE)
 	}
 }
 
+///<summary>
+///	Check that the chip answers on the bus.
+///		<returns>true if the chip acknowledged its control register address</returns>
+///</summary>
+bool SerialRAM::probe() {
+	if(!this->lockBus()) {
+		return false;
+	}
+	this->wire->beginTransmission(this->CONTROL_REGISTER);
+	uint8_t status = this->wire->endTransmission();
+	this->unlockBus();
+	return status == 0;
+}
+
+///<summary>
+///	I2C peripheral the chip is connected to.
+///</summary>
+TwoWire& SerialRAM::getWire() {
+	return *this->wire;
+}
+
+///<summary>
+///	Use the I2C peripheral "wire" without initializing it, see begin(wire, ...) otherwise.
+///</summary>
+void SerialRAM::setWire(TwoWire& wire) {
+	this->wire = &wire;
+}
+
 
 ///<summary>
 ///	Write the given byte "value" at the 16 bit address "address".
@@ -56,7 +137,7 @@ uint8_t SerialRAM::begin(const uint8_t A0, const uint8_t A1, const uint8_t SIZE)
 ///		47x04 chips valid addresses range from 0x0000 to 0x01FF
 ///		<param name="address">16 bit address</param>
 ///		<param name="value">value (byte) to be written</param>
-///		<returns>0:success, 1:data too long to fit in transmit buffer, 2 : received NACK on transmit of address, 3 : received NACK on transmit of data, 4 : other error , 5 : address out of bounds</returns>
+///		<returns>0:success, 1:data too long to fit in transmit buffer, 2 : received NACK on transmit of address, 3 : received NACK on transmit of data, 4 : other error , 5 : address out of bounds, 7 : chip busy with another transfer</returns>
 ///</summary>
 uint8_t SerialRAM::write(const uint16_t address, const uint8_t value) {
 	address16b a;
@@ -65,11 +146,16 @@ uint8_t SerialRAM::write(const uint16_t address, const uint8_t value) {
 	if(a.a8[1] & arrSize){
 		return 5;
 	}
-	Wire.beginTransmission(this->SRAM_REGISTER);
-	Wire.write(a.a8[1]);
-	Wire.write(a.a8[0]);
-	Wire.write(value);
-	return Wire.endTransmission();
+	if(!this->lockBus()) {
+		return 7;
+	}
+	this->wire->beginTransmission(this->SRAM_REGISTER);
+	this->wire->write(a.a8[1]);
+	this->wire->write(a.a8[0]);
+	this->wire->write(value);
+	uint8_t status = this->wire->endTransmission();
+	this->unlockBus();
+	return status;
 }
 
 ///<summary>
@@ -77,7 +163,7 @@ uint8_t SerialRAM::write(const uint16_t address, const uint8_t value) {
 ///		47x16 chips valid addresses range from 0x0000 to 0x07FF
 ///		47x04 chips valid addresses range from 0x0000 to 0x01FF
 ///		<param name="address">16 bit address</param>
-///		<returns>value (byte) read at the address, or 0 if address out of bounds</returns>
+///		<returns>value (byte) read at the address, or 0 if address out of bounds or chip busy with another transfer</returns>
 ///</summary>
 uint8_t SerialRAM::read(const uint16_t address) {
 	uint8_t buffer;
@@ -87,49 +173,45 @@ uint8_t SerialRAM::read(const uint16_t address) {
 	if(a.a8[1] & arrSize){
 		return 0;
 	}
-	Wire.beginTransmission(this->SRAM_REGISTER);
-	Wire.write(a.a8[1]);
-	Wire.write(a.a8[0]);
-	Wire.endTransmission();
+	if(!this->lockBus()) {
+		return 0;
+	}
+	this->wire->beginTransmission(this->SRAM_REGISTER);
+	this->wire->write(a.a8[1]);
+	this->wire->write(a.a8[0]);
+	this->wire->endTransmission();
 
-	Wire.requestFrom(this->SRAM_REGISTER, 1);
-	buffer = Wire.read();
-	Wire.endTransmission();
+	this->wire->requestFrom(this->SRAM_REGISTER, 1);
+	buffer = this->wire->read();
+	this->wire->endTransmission();
+	this->unlockBus();
 
 	return buffer;
 }
 
 uint8_t SerialRAM::readControlRegister() {
 	uint8_t buffer = 0x80;
-
-	Wire.beginTransmission(this->CONTROL_REGISTER);
-	Wire.write(0x00); //status register
-	Wire.endTransmission();
-
-	Wire.requestFrom(this->CONTROL_REGISTER, 1);
-	buffer = Wire.read();
-	Wire.endTransmission();
-
+	if(!this->lockBus()) {
+		return buffer;
+	}
+	this->readStatusRegister(&buffer);
+	this->unlockBus();
 	return buffer;
 }
 
 ///<summary>
 ///	De/Activate the "AutoStore" to EEPROM functionnality of the RAM when power is lost.
 ///		<param name="value">Set to true to activate, false otherwise</param>
+///		<returns>0:success, 1-4 : same as write(), 7 : chip busy with another transfer</returns>
 ///</summary>
-void SerialRAM::setAutoStore(const bool value)
+uint8_t SerialRAM::setAutoStore(const bool value)
 {
-	uint8_t buffer = this->readControlRegister();
-	buffer = value ? buffer|0x02 : buffer&0xfd;
-	Wire.beginTransmission(this->CONTROL_REGISTER);
-	Wire.write(0x00); //status register
-	Wire.write(buffer);
-	Wire.endTransmission();
+	return this->updateStatusRegister(0x02, value ? 0x02 : 0x00);
 }
 
 ///<summary>
 ///	De/Activate the "AutoStore" to EEPROM functionnality of the RAM when power is lost.
-///		<returns>true if auto store is active</return>
+///		<returns>true if auto store is active, false as well if the chip is busy with another transfer</return>
 ///</summary>
 bool SerialRAM::getAutoStore()
 {
@@ -140,6 +222,7 @@ bool SerialRAM::getAutoStore()
 ///<summary>
 ///	De/Activate the "AutoStore" to EEPROM functionnality of the RAM when power is lost.
 ///		<param name="value">0-7 are valid levels of protection</param>
+///		<returns>0:success, 1 : invalid level, 1-4 : same as write(), 7 : chip busy with another transfer</returns>
 ///</summary>
 uint8_t SerialRAM::setWriteProtect(const uint8_t prot)
 {
@@ -147,18 +230,12 @@ uint8_t SerialRAM::setWriteProtect(const uint8_t prot)
 	if(protectArea & 0xf8) {
 		return 1;
 	}
-	uint8_t buffer = this->readControlRegister();
-	buffer = (buffer & 0xe3) | (protectArea << 2);
-	Wire.beginTransmission(this->CONTROL_REGISTER);
-	Wire.write(0x00); //status register
-	Wire.write(buffer);
-	Wire.endTransmission();
-	return 0;
+	return this->updateStatusRegister(0x1c, protectArea << 2);
 }
 
 ///<summary>
 ///	De/Activate the "AutoStore" to EEPROM functionnality of the RAM when power is lost.
-///		<returns>level of write protection</return>
+///		<returns>level of write protection, 0 if the chip is busy with another transfer</return>
 ///</summary>
 uint8_t SerialRAM::getWriteProtect()
 {
@@ -169,20 +246,16 @@ uint8_t SerialRAM::getWriteProtect()
 ///<summary>
 ///	De/Activate the "AutoStore" to EEPROM functionnality of the RAM when power is lost.
 ///		<param name="value">Set the state of the Hardware Event bit</param>
+///		<returns>0:success, 1-4 : same as write(), 7 : chip busy with another transfer</returns>
 ///</summary>
-void SerialRAM::setEventBit(const bool value)
+uint8_t SerialRAM::setEventBit(const bool value)
 {
-	uint8_t buffer = this->readControlRegister();
-	buffer = value ? buffer|0x01 : buffer&0xfe;
-	Wire.beginTransmission(this->CONTROL_REGISTER);
-	Wire.write(0x00); //status register
-	Wire.write(buffer);
-	Wire.endTransmission();
+	return this->updateStatusRegister(0x01, value ? 0x01 : 0x00);
 }
 
 ///<summary>
 ///	De/Activate the "AutoStore" to EEPROM functionnality of the RAM when power is lost.
-///		<returns>state of hardware store bit</return>
+///		<returns>state of hardware store bit, false if the chip is busy with another transfer</return>
 ///</summary>
 bool SerialRAM::getEventBit()
 {
@@ -192,7 +265,7 @@ bool SerialRAM::getEventBit()
 
 ///<summary>
 ///	De/Activate the "AutoStore" to EEPROM functionnality of the RAM when power is lost.
-///		<returns>true if the content of both arrays matches</return>
+///		<returns>true if the content of both arrays matches, false if the chip is busy with another transfer</return>
 ///</summary>
 bool SerialRAM::getMatch()
 {
@@ -202,83 +275,417 @@ bool SerialRAM::getMatch()
 
 ///<summary>
 ///	De/Activate the "AutoStore" to EEPROM functionnality of the RAM when power is lost.
-///		<returns>true if the content of both arrays matches</return>
+///		<returns>0:success, 1-4 : same as write(), 7 : chip busy with another transfer</returns>
 ///</summary>
-void SerialRAM::store()
+uint8_t SerialRAM::store()
 {
-	Wire.beginTransmission(this->CONTROL_REGISTER);
-	Wire.write(0x55); //control register
-	Wire.write(0x33);
-	Wire.endTransmission();
+	return this->command(0x33);
 }
 
 ///<summary>
 ///	De/Activate the "AutoStore" to EEPROM functionnality of the RAM when power is lost.
-///		<returns>true if the content of both arrays matches</return>
+///		<returns>0:success, 1-4 : same as write(), 7 : chip busy with another transfer</returns>
 ///</summary>
-void SerialRAM::recall()
+uint8_t SerialRAM::recall()
 {
-	Wire.beginTransmission(this->CONTROL_REGISTER);
-	Wire.write(0x55); //control register
-	Wire.write(0xdd);
-	Wire.endTransmission();
+	return this->command(0xdd);
 }
 
 ///<summary>
 ///	Write the array of bytes "values" at the 16 bit address "address".
 ///		47x16 chips valid addresses range from 0x0000 to 0x07FF
 ///		47x04 chips valid addresses range from 0x0000 to 0x01FF
+///		The data is sent in SERIALRAM_CHUNK_SIZE transactions so it always fits in the Wire buffer.
 ///		<param name="address">16 bit address</param>
 ///		<param name="values">values (bytes) to be written</param>
-///		<returns>0:success, 1:data too long to fit in transmit buffer, 2 : received NACK on transmit of address, 3 : received NACK on transmit of data, 4 : other error </returns>
+///		<returns>0:success, 1:data too long to fit in transmit buffer, 2 : received NACK on transmit of address, 3 : received NACK on transmit of data, 4 : other error, 7 : chip busy with another transfer</returns>
 ///</summary>
 uint8_t SerialRAM::write(const uint16_t address, const uint8_t* values, const uint16_t size)
 {
 	address16b a;
 	a.a16 = address;
-	uint16_t size1 = size;
-	uint16_t arrSize = this->STORAGE_ARRAY_SIZE;
 	if(a.a8[1] & this->STORAGE_ARRAY_SIZE){
 		return 5;
 	}
-	//else if((a.a16 + size1) | (arrSize << 8)){
-	//	return 5;
-	//}
-	Wire.beginTransmission(this->SRAM_REGISTER);
-	Wire.write(a.a8[1]);
-	Wire.write(a.a8[0]);
-	Wire.write(values, size);
-	return Wire.endTransmission();
+	if(!this->lockBus()) {
+		return 7;
+	}
+	uint16_t done = 0;
+	while(done < size) {
+		uint8_t n = (size - done) > SERIALRAM_CHUNK_SIZE ? SERIALRAM_CHUNK_SIZE : (size - done);
+		if(done && this->bus) {
+			//chunk boundary: let time critical devices on the bus go first
+			this->bus->yield();
+		}
+		this->wire->beginTransmission(this->SRAM_REGISTER);
+		this->wire->write(a.a8[1]);
+		this->wire->write(a.a8[0]);
+		this->wire->write(values + done, n);
+		uint8_t status = this->wire->endTransmission();
+		if(status) {
+			this->unlockBus();
+			return status;
+		}
+		done += n;
+		a.a16 += n;
+	}
+	this->unlockBus();
+	return 0;
 }
 
 ///<summary>
 ///	Read "size" number of bytes into "values" array located at the 16 bit address "address".
 ///		Make sure values is big enough to contain all data or a segfault will occur.
+///		The data is requested in SERIALRAM_CHUNK_SIZE transactions so it always fits in the Wire buffer.
 ///		<param name="address">16 bit startign address of the data</param>
 ///		<param name="values">array to be used to store the data</param>
 ///		<param name="size">number of bytes to retrieve</param>
+///		<returns>0:success, 2 : received NACK on transmit of address, 4 : other error, 5 : address out of bounds, 7 : chip busy with another transfer</returns>
 ///</summary>
 uint8_t SerialRAM::read(const uint16_t address, uint8_t * values, const uint16_t size)
 {
 	address16b a;
 	a.a16 = address;
-	uint16_t size1 = size;
-	uint16_t arrSize = this->STORAGE_ARRAY_SIZE;
-	if(a.a8[1] & arrSize){
+	if(a.a8[1] & this->STORAGE_ARRAY_SIZE){
 		return 5;
 	}
-	//else if((a.a16 + size1) | (arrSize << 8)){
-	//	return 5;
-	//}
-	Wire.beginTransmission(this->SRAM_REGISTER);
-	Wire.write(a.a8[1]);
-	Wire.write(a.a8[0]);
-	Wire.endTransmission();
+	if(!this->lockBus()) {
+		return 7;
+	}
+	uint16_t done = 0;
+	while(done < size) {
+		uint8_t n = (size - done) > SERIALRAM_CHUNK_SIZE ? SERIALRAM_CHUNK_SIZE : (size - done);
+		if(done && this->bus) {
+			//chunk boundary: let time critical devices on the bus go first
+			this->bus->yield();
+		}
+		this->wire->beginTransmission(this->SRAM_REGISTER);
+		this->wire->write(a.a8[1]);
+		this->wire->write(a.a8[0]);
+		uint8_t status = this->wire->endTransmission();
+		if(status) {
+			this->unlockBus();
+			return status;
+		}
+		this->wire->requestFrom((uint8_t)this->SRAM_REGISTER, n);
+		for (uint8_t i = 0; i < n; i++) {
+			values[done + i] = this->wire->read();
+		}
+		done += n;
+		a.a16 += n;
+	}
+	this->unlockBus();
+	return 0;
+}
 
-	Wire.requestFrom(this->SRAM_REGISTER, size);
-	for (uint16_t i = 0; i < size; i++) {
-		values[i] = Wire.read();
+///<summary>
+///	Number of bytes in the SRAM array of the chip given to begin().
+///		<returns>2048 for 47x16 chips, 512 for 47x04 chips</returns>
+///</summary>
+uint16_t SerialRAM::capacity()
+{
+	return (uint16_t)((uint8_t)~this->STORAGE_ARRAY_SIZE + 1) << 8;
+}
+
+///<summary>
+///	Set "size" bytes starting at the 16 bit address "address" to "value", one chunk at a time.
+///		<param name="address">16 bit starting address</param>
+///		<param name="value">value (byte) to be written</param>
+///		<param name="size">number of bytes to set</param>
+///		<returns>same as write()</returns>
+///</summary>
+uint8_t SerialRAM::fill(const uint16_t address, const uint8_t value, const uint16_t size)
+{
+	uint8_t buffer[SERIALRAM_CHUNK_SIZE];
+	memset(buffer, value, sizeof(buffer));
+	uint16_t done = 0;
+	while(done < size) {
+		uint8_t n = (size - done) > SERIALRAM_CHUNK_SIZE ? SERIALRAM_CHUNK_SIZE : (size - done);
+		if(done && this->bus) {
+			this->bus->poll();
+		}
+		uint8_t status = this->write(address + done, buffer, n);
+		if(status) {
+			return status;
+		}
+		done += n;
 	}
-	Wire.endTransmission();
+	return 0;
 }
 
+///<summary>
+///	Copy "size" bytes from "source" to "destination" inside the chip, one chunk at a time.
+///		Overlapping ranges are handled like memmove: the copy runs backwards when destination is above source.
+///		Only SERIALRAM_CHUNK_SIZE bytes of host RAM are used whatever the size.
+///		<param name="destination">16 bit address the data is copied to</param>
+///		<param name="source">16 bit address the data is copied from</param>
+///		<param name="size">number of bytes to copy</param>
+///		<returns>same as write()</returns>
+///</summary>
+uint8_t SerialRAM::move(const uint16_t destination, const uint16_t source, const uint16_t size)
+{
+	uint8_t buffer[SERIALRAM_CHUNK_SIZE];
+	if(destination == source) {
+		return 0;
+	}
+	bool backwards = destination > source && destination < source + size;
+	uint16_t done = 0;
+	while(done < size) {
+		uint8_t n = (size - done) > SERIALRAM_CHUNK_SIZE ? SERIALRAM_CHUNK_SIZE : (size - done);
+		uint16_t offset = backwards ? size - done - n : done;
+		if(done && this->bus) {
+			this->bus->poll();
+		}
+		uint8_t status = this->read(source + offset, buffer, n);
+		if(!status) {
+			status = this->write(destination + offset, buffer, n);
+		}
+		if(status) {
+			return status;
+		}
+		done += n;
+	}
+	return 0;
+}
+
+///<summary>
+///	Search the chip for "pattern" in [address, address + size), one chunk at a time.
+///		The last patternSize - 1 bytes of each chunk are carried over to the next one so matches spanning
+///		a chunk boundary are found, and reading stops at the first match. Candidates for the first pattern byte
+///		are located a word at a time, whatever the pattern length. Host RAM use is two chunks whatever the size.
+///		<param name="address">16 bit address where the search starts</param>
+///		<param name="size">number of bytes searched</param>
+///		<param name="pattern">bytes to look for</param>
+///		<param name="patternSize">length of the pattern, 1 to SERIALRAM_CHUNK_SIZE</param>
+///		<returns>address of the first match, SERIALRAM_NOT_FOUND if there is none, the pattern is too long or a read failed</returns>
+///</summary>
+uint16_t SerialRAM::find(const uint16_t address, const uint16_t size, const uint8_t* pattern, const uint8_t patternSize)
+{
+	uint8_t buffer[2 * SERIALRAM_CHUNK_SIZE];
+	if(!patternSize || patternSize > SERIALRAM_CHUNK_SIZE || patternSize > size) {
+		return SERIALRAM_NOT_FOUND;
+	}
+	uint8_t kept = 0;
+	uint16_t done = 0;
+	while(done < size) {
+		uint8_t n = (size - done) > SERIALRAM_CHUNK_SIZE ? SERIALRAM_CHUNK_SIZE : (size - done);
+		if(this->read(address + done, buffer + kept, n)) {
+			return SERIALRAM_NOT_FOUND;
+		}
+		uint8_t length = kept + n;
+		uint8_t position = 0;
+		while(length - position >= patternSize) {
+			position += findByte(buffer + position, length - position - patternSize + 1, pattern[0]);
+			if(length - position < patternSize) {
+				break;
+			}
+			if(!memcmp(buffer + position + 1, pattern + 1, patternSize - 1)) {
+				return address + done - kept + position;
+			}
+			position++;
+		}
+		done += n;
+		kept = patternSize - 1 < length ? patternSize - 1 : length;
+		memmove(buffer, buffer + length - kept, kept);
+	}
+	return SERIALRAM_NOT_FOUND;
+}
+
+uint8_t SerialRAM::readModifyWrite(const uint16_t address, const uint8_t width, const uint8_t op, const uint32_t operand, uint32_t* value)
+{
+	address16b a;
+	a.a16 = address;
+	if(a.a8[1] & this->STORAGE_ARRAY_SIZE){
+		return 5;
+	}
+	if(!this->lockBus()) {
+		return 7;
+	}
+	//address then read with repeated starts and no stop, the bus stays ours until the write is done
+	this->wire->beginTransmission(this->SRAM_REGISTER);
+	this->wire->write(a.a8[1]);
+	this->wire->write(a.a8[0]);
+	uint8_t status = this->wire->endTransmission((uint8_t)false);
+	if(status) {
+		this->unlockBus();
+		return status;
+	}
+	this->wire->requestFrom((uint8_t)this->SRAM_REGISTER, width, (uint8_t)false);
+	uint32_t current = 0;
+	for(uint8_t i = 0; i < width; i++) {
+		current |= (uint32_t)(uint8_t)this->wire->read() << (8 * i);
+	}
+	//signed values arrive sign extended, only the low "width" bytes take part in the comparison
+	uint32_t mask = width < 4 ? ((uint32_t)1 << (8 * width)) - 1 : 0xffffffff;
+
+	uint32_t result;
+	switch(op) {
+	case SERIALRAM_RMW_ADD:
+		result = current + operand;
+		break;
+	case SERIALRAM_RMW_OR:
+		result = current | operand;
+		break;
+	case SERIALRAM_RMW_AND:
+		result = current & operand;
+		break;
+	default:
+		//compare exchange: "value" holds the expected value on entry
+		if(current != (*value & mask)) {
+			//release the bus with an empty write to the same address
+			this->wire->beginTransmission(this->SRAM_REGISTER);
+			this->wire->write(a.a8[1]);
+			this->wire->write(a.a8[0]);
+			this->wire->endTransmission();
+			this->unlockBus();
+			*value = current;
+			return 6;
+		}
+		result = operand & mask;
+		break;
+	}
+
+	this->wire->beginTransmission(this->SRAM_REGISTER);
+	this->wire->write(a.a8[1]);
+	this->wire->write(a.a8[0]);
+	for(uint8_t i = 0; i < width; i++) {
+		this->wire->write((uint8_t)(result >> (8 * i)));
+	}
+	status = this->wire->endTransmission();
+	this->unlockBus();
+	*value = current;
+	return status;
+}
+
+///<summary>
+///	Share the bus manager "bus" with the other drivers of the I2C bus.
+///		Transfers then hold the bus while they run and hand it to pending time critical devices at every chunk boundary.
+///		<param name="bus">bus manager, or null to stop using one</param>
+///</summary>
+void SerialRAM::setBus(SerialRAMBus* bus)
+{
+	this->bus = bus;
+}
+
+bool SerialRAM::lockBus()
+{
+	if(!serialRAMTryLock(&this->busy)) {
+		return false;
+	}
+	if(this->bus && !this->bus->acquire()) {
+		serialRAMUnlock(&this->busy);
+		return false;
+	}
+	return true;
+}
+
+void SerialRAM::unlockBus()
+{
+	if(this->bus) {
+		this->bus->release();
+	}
+	serialRAMUnlock(&this->busy);
+}
+
+///<summary>
+///	Set "flag" and tell whether it was clear, atomically with respect to interrupt handlers.
+///		<returns>true if the caller now owns the flag</returns>
+///</summary>
+bool serialRAMTryLock(volatile bool* flag)
+{
+#if defined(__AVR__)
+	//byte sized atomics are plain loads and stores on AVR, mask interrupts around the test and set
+	uint8_t sreg = SREG;
+	cli();
+	bool acquired = !*flag;
+	*flag = true;
+	SREG = sreg;
+	return acquired;
+#else
+	return !__atomic_test_and_set((void*)flag, __ATOMIC_ACQUIRE);
+#endif
+}
+
+///<summary>
+///	Clear a flag owned through serialRAMTryLock().
+///</summary>
+void serialRAMUnlock(volatile bool* flag)
+{
+#if defined(__AVR__)
+	*flag = false;
+#else
+	__atomic_clear((bool*)flag, __ATOMIC_RELEASE);
+#endif
+}
+
+//I2C peripherals already initialized by serialRAMBeginWire()
+#ifndef SERIALRAM_MAX_TRANSPORTS
+	#define SERIALRAM_MAX_TRANSPORTS 4
+#endif
+static TwoWire* startedTransports[SERIALRAM_MAX_TRANSPORTS];
+
+///<summary>
+///	Initialize the I2C peripheral "wire" unless a chip already did, so bringing up several chips
+///	does not reset the peripheral under transfers of the other drivers.
+///		<returns>true if this call initialized the peripheral</returns>
+///</summary>
+bool serialRAMBeginWire(TwoWire* wire)
+{
+	for(uint8_t i = 0; i < SERIALRAM_MAX_TRANSPORTS; i++) {
+		if(startedTransports[i] == wire) {
+			return false;
+		}
+		if(!startedTransports[i]) {
+			startedTransports[i] = wire;
+			break;
+		}
+	}
+	//with more peripherals than slots the extra ones are initialized each time, as before
+	wire->begin();
+	return true;
+}
+
+//Read the status register into "value", the caller holds the bus
+uint8_t SerialRAM::readStatusRegister(uint8_t* value) {
+	this->wire->beginTransmission(this->CONTROL_REGISTER);
+	this->wire->write(0x00); //status register
+	uint8_t status = this->wire->endTransmission();
+	if(status) {
+		return status;
+	}
+	if(this->wire->requestFrom(this->CONTROL_REGISTER, 1) != 1) {
+		return 4;
+	}
+	*value = this->wire->read();
+	return 0;
+}
+
+//Replace the status register bits selected by "mask" with "bits", holding the bus from the read to the write
+uint8_t SerialRAM::updateStatusRegister(const uint8_t mask, const uint8_t bits) {
+	if(!this->lockBus()) {
+		return 7;
+	}
+	uint8_t buffer;
+	uint8_t status = this->readStatusRegister(&buffer);
+	if(!status) {
+		this->wire->beginTransmission(this->CONTROL_REGISTER);
+		this->wire->write(0x00); //status register
+		this->wire->write((buffer & ~mask) | bits);
+		status = this->wire->endTransmission();
+	}
+	this->unlockBus();
+	return status;
+}
+
+//Send "value" to the command register (0x33 store, 0xdd recall)
+uint8_t SerialRAM::command(const uint8_t value) {
+	if(!this->lockBus()) {
+		return 7;
+	}
+	this->wire->beginTransmission(this->CONTROL_REGISTER);
+	this->wire->write(0x55); //control register
+	this->wire->write(value);
+	uint8_t status = this->wire->endTransmission();
+	this->unlockBus();
+	return status;
+}
@@ -19,7 +19,27 @@
 #else
 	#include "WProgram.h"
 #endif
+#include <Wire.h>
 
+//Maximum number of data bytes moved in a single I2C transaction. Must fit in the Wire buffer along with the 2 address bytes.
+#ifndef SERIALRAM_CHUNK_SIZE
+	#define SERIALRAM_CHUNK_SIZE 16
+#endif
+
+//Operations of the atomic read-modify-write primitives
+#define SERIALRAM_RMW_ADD 0
+#define SERIALRAM_RMW_OR 1
+#define SERIALRAM_RMW_AND 2
+#define SERIALRAM_RMW_CAS 3
+
+//Returned by find() when the pattern does not occur
+#define SERIALRAM_NOT_FOUND 0xffff
+
+class SerialRAMBus;
+
+bool serialRAMTryLock(volatile bool* flag);
+void serialRAMUnlock(volatile bool* flag);
+bool serialRAMBeginWire(TwoWire* wire);
 
 typedef union {
 	uint16_t a16;
@@ -31,30 +51,112 @@ private:
 	int8_t SRAM_REGISTER;
 	int8_t CONTROL_REGISTER;
 	int8_t STORAGE_ARRAY_SIZE;
+	volatile bool busy;
+	SerialRAMBus* bus;
+	TwoWire* wire;
+
+	bool lockBus();
+	void unlockBus();
+	uint8_t readModifyWrite(const uint16_t address, const uint8_t width, const uint8_t op, const uint32_t operand, uint32_t* value);
+	uint8_t readStatusRegister(uint8_t* value);
+	uint8_t updateStatusRegister(const uint8_t mask, const uint8_t bits);
+	uint8_t command(const uint8_t value);
 
 public:
+	SerialRAM();
 	
 	uint8_t begin(const uint8_t A0 = 0, const uint8_t A1 = 0, const uint8_t SIZE = 16);
+	uint8_t begin(TwoWire& wire, const uint8_t A0 = 0, const uint8_t A1 = 0, const uint8_t SIZE = 16);
+	uint8_t configure(const uint8_t A0 = 0, const uint8_t A1 = 0, const uint8_t SIZE = 16);
+	bool probe();
+	TwoWire& getWire();
+	void setWire(TwoWire& wire);
 	uint8_t write(const uint16_t address, const uint8_t value);
 	uint8_t read(const uint16_t address);
-	void setAutoStore(const bool value);
+	uint8_t setAutoStore(const bool value);
 	bool getAutoStore();
 	
-	void store();
-	void recall();
+	uint8_t store();
+	uint8_t recall();
 	
 	uint8_t setWriteProtect(const uint8_t prot);
 	uint8_t getWriteProtect();
 	
-	void setEventBit(const bool value);
+	uint8_t setEventBit(const bool value);
 	bool getEventBit();
 	
 	bool getMatch();
 	
 	uint8_t write(const uint16_t address, const uint8_t* values, const uint16_t size);
 	uint8_t read(const uint16_t address, uint8_t* values, const uint16_t size);
+	
+	uint16_t capacity();
+	uint8_t fill(const uint16_t address, const uint8_t value, const uint16_t size);
+	uint8_t move(const uint16_t destination, const uint16_t source, const uint16_t size);
+	uint16_t find(const uint16_t address, const uint16_t size, const uint8_t* pattern, const uint8_t patternSize);
 
 	uint8_t readControlRegister();
+	void setBus(SerialRAMBus* bus);
+
+	///<summary>
+	///	Atomically add "operand" to the little endian 8, 16 or 32 bit value at "address".
+	///		The read and the write are chained with repeated starts, so the bus is held for the whole operation,
+	///		and a caller interrupting another transfer on this chip (an ISR for instance) gets 7 instead of corrupting it.
+	///		The busy flag only makes a single instance reentrancy-safe: chips sharing a TwoWire are serialized only when
+	///		they share a SerialRAMBus (see setBus()).
+	///		<param name="previous">value before the addition, may be null</param>
+	///		<returns>0:success, 1-4 : same as write(), 5 : address out of bounds, 7 : chip busy with another transfer</returns>
+	///</summary>
+	template<typename T>
+	uint8_t fetchAdd(const uint16_t address, const T operand, T* previous = 0) {
+		uint32_t value;
+		uint8_t status = this->readModifyWrite(address, sizeof(T), SERIALRAM_RMW_ADD, (uint32_t)operand, &value);
+		if(previous) {
+			*previous = (T)value;
+		}
+		return status;
+	}
+
+	///<summary>
+	///	Atomically OR "operand" into the value at "address", see fetchAdd().
+	///</summary>
+	template<typename T>
+	uint8_t fetchOr(const uint16_t address, const T operand, T* previous = 0) {
+		uint32_t value;
+		uint8_t status = this->readModifyWrite(address, sizeof(T), SERIALRAM_RMW_OR, (uint32_t)operand, &value);
+		if(previous) {
+			*previous = (T)value;
+		}
+		return status;
+	}
+
+	///<summary>
+	///	Atomically AND "operand" into the value at "address", see fetchAdd().
+	///</summary>
+	template<typename T>
+	uint8_t fetchAnd(const uint16_t address, const T operand, T* previous = 0) {
+		uint32_t value;
+		uint8_t status = this->readModifyWrite(address, sizeof(T), SERIALRAM_RMW_AND, (uint32_t)operand, &value);
+		if(previous) {
+			*previous = (T)value;
+		}
+		return status;
+	}
+
+	///<summary>
+	///	Atomically replace the value at "address" by "desired" if it equals "expected".
+	///		When the values differ nothing is written and "expected" receives the current value.
+	///		<returns>0:exchanged, 1-5 : same as fetchAdd(), 6 : value differs from expected, 7 : chip busy</returns>
+	///</summary>
+	template<typename T>
+	uint8_t compareExchange(const uint16_t address, T* expected, const T desired) {
+		uint32_t value = (uint32_t)*expected;
+		uint8_t status = this->readModifyWrite(address, sizeof(T), SERIALRAM_RMW_CAS, (uint32_t)desired, &value);
+		if(status == 6) {
+			*expected = (T)value;
+		}
+		return status;
+	}
 };
 
 
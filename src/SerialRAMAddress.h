@@ -0,0 +1,24 @@
+/*
+	SerialRAMAddress.h
+	I2C addresses of a 47x04/47x16 chip from its A0 and A1 straps, shared by the Arduino driver and the Linux transports
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#ifndef _SerialRAMAddress_h
+#define _SerialRAMAddress_h
+
+#include <stdint.h>
+
+//7 bit addresses of the SRAM array and of the control registers with both straps low
+#define SERIALRAM_SRAM_ADDRESS 0x50
+#define SERIALRAM_CONTROL_ADDRESS 0x18
+
+//Bits added to both addresses by the A0 and A1 straps (logic 0 or 1). A1 is address bit 1 and A0 address bit 2.
+inline uint8_t serialRAMAddressMask(const uint8_t A0, const uint8_t A1) {
+	return ((A0 << 1) | A1) << 1;
+}
+
+#endif
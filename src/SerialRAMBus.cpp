@@ -0,0 +1,168 @@
+/*
+	SerialRAMBus.cpp
+	Arbitration of an I2C bus shared between SerialRAM chips and other devices (RTC, ADC...)
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#include <stdint.h>
+#include "SerialRAMBus.h"
+
+
+///<summary>
+///	Create a free bus with no device attached, on the I2C peripheral "wire".
+///		Chips registered with add() are brought up together by begin(), other chips can join with SerialRAM::setBus().
+///		Every driver wraps its transfers in acquire() / release(), so only one of them talks at a time.
+///		Long SerialRAM transfers call yield() between chunks, so a time critical device waits at most one
+///		chunk transfer (about 1.8 ms for 16 bytes at 100 kHz, lower SERIALRAM_CHUNK_SIZE to tighten it).
+///</summary>
+SerialRAMBus::SerialRAMBus(TwoWire& wire) {
+	this->count = 0;
+	this->owned = false;
+	this->wire = &wire;
+	this->chipTotal = 0;
+}
+
+///<summary>
+///	Register a chip of this bus, to be brought up by begin(). Nothing is sent on the bus yet.
+///	<param name="ram">chip to register</param>
+///	<param name="A0">A0 value (logic 0 or 1) of the chip</param>
+///	<param name="A1">A1 value (logic 0 or 1) of the chip</param>
+///	<param name="SIZE">size of the chip in kbits (4 or 16)</param>
+///	<returns>index of the chip in the bit mask returned by begin(), or -1 if SERIALRAM_BUS_CHIPS chips are already registered</returns>
+///</summary>
+int8_t SerialRAMBus::add(SerialRAM& ram, const uint8_t A0, const uint8_t A1, const uint8_t SIZE) {
+	if(this->chipTotal >= SERIALRAM_BUS_CHIPS) {
+		return -1;
+	}
+	chip* c = &this->chips[this->chipTotal];
+	c->ram = &ram;
+	c->A0 = A0;
+	c->A1 = A1;
+	c->size = SIZE;
+	return this->chipTotal++;
+}
+
+///<summary>
+///	Bring every registered chip up in a single pass: the I2C peripheral is initialized once (and not at all
+///	if another chip or bus already did), then each chip is configured, attached to this bus and probed.
+///		<returns>bit mask of the chips that answered, bit i standing for the chip of index i</returns>
+///</summary>
+uint8_t SerialRAMBus::begin() {
+	serialRAMBeginWire(this->wire);
+	uint8_t present = 0;
+	for(uint8_t i = 0; i < this->chipTotal; i++) {
+		chip* c = &this->chips[i];
+		c->ram->setWire(*this->wire);
+		c->ram->configure(c->A0, c->A1, c->size);
+		c->ram->setBus(this);
+		if(c->ram->probe()) {
+			present |= 1 << i;
+		}
+	}
+	return present;
+}
+
+///<summary>
+///	Number of chips registered with add().
+///</summary>
+uint8_t SerialRAMBus::chipCount() {
+	return this->chipTotal;
+}
+
+///<summary>
+///	Chip registered with add() at "index", or null.
+///</summary>
+SerialRAM* SerialRAMBus::getChip(const uint8_t index) {
+	return index < this->chipTotal ? this->chips[index].ram : 0;
+}
+
+///<summary>
+///	Register a time critical device. Its "service" function performs its transfers and is called with the bus held,
+///	at the next chunk boundary of an ongoing transfer or at the next poll(), after request() was called.
+///	Devices attached first are served first. A service must not use a SerialRAM chip sharing this bus.
+///		<param name="service">function running the pending transfers of the device</param>
+///		<param name="context">pointer given back to service</param>
+///		<returns>id of the device for request(), or -1 if SERIALRAM_BUS_CLIENTS devices are already attached</returns>
+///</summary>
+int8_t SerialRAMBus::attach(SerialRAMBusService service, void* context) {
+	if(this->count >= SERIALRAM_BUS_CLIENTS) {
+		return -1;
+	}
+	client* c = &this->clients[this->count];
+	c->service = service;
+	c->context = context;
+	c->pending = false;
+	c->requested = 0;
+	c->maxLatency = 0;
+	return this->count++;
+}
+
+///<summary>
+///	Ask for the service of device "id" to run as soon as the bus can be handed over. Safe in an interrupt handler.
+///</summary>
+void SerialRAMBus::request(const uint8_t id) {
+	if(id >= this->count || this->clients[id].pending) {
+		return;
+	}
+	this->clients[id].requested = micros();
+	this->clients[id].pending = true;
+}
+
+///<summary>
+///	Longest time measured between request() and the start of the service of device "id", in microseconds.
+///</summary>
+uint32_t SerialRAMBus::getMaxLatency(const uint8_t id) {
+	return id < this->count ? this->clients[id].maxLatency : 0;
+}
+
+///<summary>
+///	Take the bus before a transfer.
+///		<returns>true if the bus is now owned by the caller, false if another transfer is running</returns>
+///</summary>
+bool SerialRAMBus::acquire() {
+	return serialRAMTryLock(&this->owned);
+}
+
+///<summary>
+///	Give the bus back after a transfer.
+///</summary>
+void SerialRAMBus::release() {
+	serialRAMUnlock(&this->owned);
+}
+
+///<summary>
+///	Run the pending services while the caller holds the bus between two of its own transactions.
+///</summary>
+void SerialRAMBus::yield() {
+	this->serve();
+}
+
+///<summary>
+///	Run the pending services if the bus is free. Call it from the main loop.
+///</summary>
+void SerialRAMBus::poll() {
+	if(!this->acquire()) {
+		return;
+	}
+	this->serve();
+	this->release();
+}
+
+void SerialRAMBus::serve() {
+	for(uint8_t i = 0; i < this->count; i++) {
+		client* c = &this->clients[i];
+		if(!c->pending) {
+			continue;
+		}
+		uint32_t latency = micros() - c->requested;
+		if(latency > c->maxLatency) {
+			c->maxLatency = latency;
+		}
+		//clear first so a request made during the service is not lost
+		c->pending = false;
+		c->service(c->context);
+	}
+}
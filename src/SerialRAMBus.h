@@ -0,0 +1,73 @@
+/*
+	SerialRAMBus.h
+	Arbitration of an I2C bus shared between SerialRAM chips and other devices (RTC, ADC...)
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#ifndef _SerialRAMBus_h
+#define _SerialRAMBus_h
+
+#include <Wire.h>
+#include "SerialRAM.h"
+
+//Largest number of time critical devices that can be attached to a bus
+#ifndef SERIALRAM_BUS_CLIENTS
+	#define SERIALRAM_BUS_CLIENTS 4
+#endif
+
+//Largest number of SerialRAM chips brought up together by SerialRAMBus::begin(). Two address pins allow 4 chips per bus.
+#ifndef SERIALRAM_BUS_CHIPS
+	#define SERIALRAM_BUS_CHIPS 4
+#endif
+
+//Called with the bus held, to run the pending transfer of a time critical device
+typedef void (*SerialRAMBusService)(void* context);
+
+class SerialRAMBus {
+private:
+	typedef struct {
+		SerialRAMBusService service;
+		void* context;
+		volatile bool pending;
+		uint32_t requested;
+		uint32_t maxLatency;
+	} client;
+
+	typedef struct {
+		SerialRAM* ram;
+		uint8_t A0;
+		uint8_t A1;
+		uint8_t size;
+	} chip;
+
+	client clients[SERIALRAM_BUS_CLIENTS];
+	uint8_t count;
+	volatile bool owned;
+	TwoWire* wire;
+	chip chips[SERIALRAM_BUS_CHIPS];
+	uint8_t chipTotal;
+
+	void serve();
+
+public:
+	SerialRAMBus(TwoWire& wire = Wire);
+
+	int8_t add(SerialRAM& ram, const uint8_t A0 = 0, const uint8_t A1 = 0, const uint8_t SIZE = 16);
+	uint8_t begin();
+	uint8_t chipCount();
+	SerialRAM* getChip(const uint8_t index);
+
+	int8_t attach(SerialRAMBusService service, void* context = 0);
+	void request(const uint8_t id);
+	uint32_t getMaxLatency(const uint8_t id);
+
+	bool acquire();
+	void release();
+	void yield();
+	void poll();
+};
+
+#endif
@@ -0,0 +1,465 @@
+/*
+	SerialRAMCache.cpp
+	Small write back cache in front of a SerialRAM chip, with array style access through a proxy reference
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#include <stdint.h>
+#include "SerialRAMCache.h"
+
+#define LINE_FULL (SERIALRAM_CHUNK_SIZE == 32 ? 0xffffffffUL : ((1UL << SERIALRAM_CHUNK_SIZE) - 1))
+#define NO_TAG 0xffff
+
+
+SerialRAMRef::SerialRAMRef(SerialRAMCache* cache, const uint16_t address) {
+	this->cache = cache;
+	this->address = address;
+}
+
+SerialRAMRef::operator uint8_t() const {
+	return this->cache->get(this->address);
+}
+
+SerialRAMRef& SerialRAMRef::operator=(const uint8_t value) {
+	this->cache->set(this->address, value);
+	return *this;
+}
+
+SerialRAMRef& SerialRAMRef::operator=(const SerialRAMRef& other) {
+	return *this = (uint8_t)other;
+}
+
+SerialRAMRef& SerialRAMRef::operator+=(const uint8_t value) {
+	return *this = (uint8_t)(*this + value);
+}
+
+SerialRAMRef& SerialRAMRef::operator-=(const uint8_t value) {
+	return *this = (uint8_t)(*this - value);
+}
+
+SerialRAMRef& SerialRAMRef::operator|=(const uint8_t value) {
+	return *this = (uint8_t)(*this | value);
+}
+
+SerialRAMRef& SerialRAMRef::operator&=(const uint8_t value) {
+	return *this = (uint8_t)(*this & value);
+}
+
+SerialRAMRef& SerialRAMRef::operator^=(const uint8_t value) {
+	return *this = (uint8_t)(*this ^ value);
+}
+
+SerialRAMRef& SerialRAMRef::operator++() {
+	return *this += 1;
+}
+
+SerialRAMRef& SerialRAMRef::operator--() {
+	return *this -= 1;
+}
+
+
+///<summary>
+///	Create an empty cache in front of "ram".
+///		Accesses to consecutive addresses hit the same line, so a loop over an array costs one transaction
+///		per SERIALRAM_CHUNK_SIZE bytes instead of one per byte. Writes stay in the cache until the line
+///		is evicted or flush() is called, and a line that is only written is never read from the chip.
+///		The line evicted on a miss is chosen by SERIALRAM_CACHE_POLICY: round robin, LRU or CLOCK.
+///	<param name="ram">initialized SerialRAM chip</param>
+///</summary>
+SerialRAMCache::SerialRAMCache(SerialRAM& ram) {
+	this->ram = &ram;
+	this->next = 0;
+	this->status = 0;
+#if SERIALRAM_CACHE_POLICY == SERIALRAM_CACHE_LRU
+	this->clock = 0;
+#endif
+	this->pinCount = 0;
+	this->streaming = false;
+	this->invalidate();
+	this->resetStatistics();
+}
+
+///<summary>
+///	Array style access: cache[address] = value; value = cache[address];
+///		<param name="address">16 bit address</param>
+///		<returns>proxy standing for the byte at address</returns>
+///</summary>
+SerialRAMRef SerialRAMCache::operator[](const uint16_t address) {
+	return SerialRAMRef(this, address);
+}
+
+///<summary>
+///	Read the byte located at "address", fetching its line if needed.
+///		<returns>value (byte) read at the address, or 0 on error (see getStatus())</returns>
+///</summary>
+uint8_t SerialRAMCache::get(const uint16_t address) {
+	uint16_t tag = address / SERIALRAM_CHUNK_SIZE;
+	uint8_t offset = address % SERIALRAM_CHUNK_SIZE;
+	uint8_t status = 0;
+	line* l = this->lookup(tag);
+	if(!l) {
+		l = this->allocate(tag, &status);
+		if(!l) {
+			//every line is pinned to other addresses, or the victim could not be written back
+			if(status) {
+				this->status = status;
+			}
+			uint8_t value = 0;
+			status = this->ram->read(address, &value, 1);
+			if(status) {
+				this->status = status;
+			}
+			return value;
+		}
+	}
+	if(!(l->valid & (1UL << offset))) {
+		status = this->fetch(l);
+	}
+	if(status) {
+		this->status = status;
+		return 0;
+	}
+	return l->data[offset];
+}
+
+///<summary>
+///	Write the byte "value" at "address" in the cache. The chip is updated when the line is written back.
+///		When the line to evict cannot be written back, it stays in the cache and the byte is written straight to the chip.
+///		<returns>0:success, or the error of a write going straight to the chip. A failed write back is kept for getStatus().</returns>
+///</summary>
+uint8_t SerialRAMCache::set(const uint16_t address, const uint8_t value) {
+	uint16_t tag = address / SERIALRAM_CHUNK_SIZE;
+	uint8_t offset = address % SERIALRAM_CHUNK_SIZE;
+	uint8_t status = 0;
+	line* l = this->lookup(tag);
+	if(!l) {
+		l = this->allocate(tag, &status);
+		if(!l) {
+			if(status) {
+				this->status = status;
+			}
+			status = this->ram->write(address, value);
+			if(status) {
+				this->status = status;
+			}
+			return status;
+		}
+	}
+	l->data[offset] = value;
+	l->valid |= 1UL << offset;
+	l->dirty |= 1UL << offset;
+	return 0;
+}
+
+///<summary>
+///	Bulk read going straight to the chip. Dirty cached bytes in the range are written back first.
+///		<returns>same as SerialRAM::read()</returns>
+///</summary>
+uint8_t SerialRAMCache::read(const uint16_t address, uint8_t* values, const uint16_t size) {
+	uint8_t status = this->flush(address, size);
+	if(status) {
+		return status;
+	}
+	return this->ram->read(address, values, size);
+}
+
+///<summary>
+///	Bulk write going straight to the chip. Cached lines in the range are updated so they stay coherent.
+///		<returns>same as SerialRAM::write()</returns>
+///</summary>
+uint8_t SerialRAMCache::write(const uint16_t address, const uint8_t* values, const uint16_t size) {
+	uint8_t status = this->ram->write(address, values, size);
+	if(status) {
+		return status;
+	}
+	for(uint8_t i = 0; i < SERIALRAM_CACHE_LINES; i++) {
+		line* l = &this->lines[i];
+		if(l->tag == NO_TAG) {
+			continue;
+		}
+		uint16_t start = l->tag * SERIALRAM_CHUNK_SIZE;
+		for(uint8_t j = 0; j < SERIALRAM_CHUNK_SIZE; j++) {
+			uint16_t a = start + j;
+			if(a >= address && a - address < size) {
+				l->data[j] = values[a - address];
+				l->valid |= 1UL << j;
+				l->dirty &= ~(1UL << j);
+			}
+		}
+	}
+	return 0;
+}
+
+///<summary>
+///	Write every dirty line back to the chip.
+///		<returns>same as SerialRAM::write()</returns>
+///</summary>
+uint8_t SerialRAMCache::flush() {
+	return this->flush(0, 0xffff);
+}
+
+///<summary>
+///	Write back the dirty lines overlapping [address, address + size).
+///		<returns>same as SerialRAM::write()</returns>
+///</summary>
+uint8_t SerialRAMCache::flush(const uint16_t address, const uint16_t size) {
+	if(!size) {
+		return 0;
+	}
+	uint16_t first = address / SERIALRAM_CHUNK_SIZE;
+	uint16_t last = ((uint32_t)address + size - 1) / SERIALRAM_CHUNK_SIZE;
+	for(uint8_t i = 0; i < SERIALRAM_CACHE_LINES; i++) {
+		line* l = &this->lines[i];
+		if(l->tag != NO_TAG && l->tag >= first && l->tag <= last) {
+			uint8_t status = this->writeBack(l);
+			if(status) {
+				return status;
+			}
+		}
+	}
+	return 0;
+}
+
+///<summary>
+///	Drop every line WITHOUT writing dirty bytes back. Use it when the chip was changed behind the cache.
+///</summary>
+void SerialRAMCache::invalidate() {
+	for(uint8_t i = 0; i < SERIALRAM_CACHE_LINES; i++) {
+		this->lines[i].tag = NO_TAG;
+		this->lines[i].valid = 0;
+		this->lines[i].dirty = 0;
+#if SERIALRAM_CACHE_POLICY == SERIALRAM_CACHE_LRU
+		this->lines[i].stamp = 0;
+#elif SERIALRAM_CACHE_POLICY == SERIALRAM_CACHE_CLOCK
+		this->lines[i].referenced = false;
+#endif
+	}
+}
+
+///<summary>
+///	Last error met by an access that cannot report it, such as the proxy returned by operator[]. Reading it clears it.
+///		<returns>0 if no error, otherwise same as SerialRAM::write()</returns>
+///</summary>
+uint8_t SerialRAMCache::getStatus() {
+	uint8_t status = this->status;
+	this->status = 0;
+	return status;
+}
+
+///<summary>
+///	Keep the lines of [address, address + size) in the cache once loaded: they are never chosen for eviction.
+///		Pinning more lines than SERIALRAM_CACHE_LINES leaves no line for the other addresses, which then go straight to the chip.
+///		<returns>true if pinned, false if SERIALRAM_CACHE_PINS ranges are already pinned</returns>
+///</summary>
+bool SerialRAMCache::pin(const uint16_t address, const uint16_t size) {
+	if(this->pinCount >= SERIALRAM_CACHE_PINS || !size) {
+		return false;
+	}
+	this->pins[this->pinCount].first = address / SERIALRAM_CHUNK_SIZE;
+	this->pins[this->pinCount].last = ((uint32_t)address + size - 1) / SERIALRAM_CHUNK_SIZE;
+	this->pinCount++;
+	return true;
+}
+
+///<summary>
+///	Remove every pinned range.
+///</summary>
+void SerialRAMCache::unpin() {
+	this->pinCount = 0;
+}
+
+///<summary>
+///	Hint that the next accesses stream through memory once, for instance while scanning a log.
+///		Lines loaded while streaming are the next ones evicted and hits do not refresh any line,
+///		so the hot lines of the rest of the program survive the scan.
+///</summary>
+void SerialRAMCache::setStreaming(const bool streaming) {
+	this->streaming = streaming;
+}
+
+///<summary>
+///	Hit, miss, eviction, write back and bypass counters since the last resetStatistics(), to tune the policy and pins.
+///</summary>
+SerialRAMCacheStats SerialRAMCache::getStatistics() {
+	return this->stats;
+}
+
+void SerialRAMCache::resetStatistics() {
+	memset(&this->stats, 0, sizeof(this->stats));
+}
+
+///<summary>
+///	Chip behind the cache.
+///</summary>
+SerialRAM& SerialRAMCache::device() {
+	return *this->ram;
+}
+
+SerialRAMCache::line* SerialRAMCache::lookup(const uint16_t tag) {
+	for(uint8_t i = 0; i < SERIALRAM_CACHE_LINES; i++) {
+		if(this->lines[i].tag == tag) {
+			this->stats.hits++;
+			//a streamed line must stay the next victim, and a scan must not age the hot lines behind it
+			if(!this->streaming) {
+				this->touch(&this->lines[i]);
+			}
+			return &this->lines[i];
+		}
+	}
+	this->stats.misses++;
+	return 0;
+}
+
+SerialRAMCache::line* SerialRAMCache::allocate(const uint16_t tag, uint8_t* status) {
+	int8_t victim = this->selectVictim();
+	if(victim < 0) {
+		this->stats.bypasses++;
+		return 0;
+	}
+	line* l = &this->lines[victim];
+	//a dirty line that cannot be written back stays resident, the access goes straight to the chip
+	*status = this->writeBack(l);
+	if(*status) {
+		this->stats.bypasses++;
+		return 0;
+	}
+	if(l->tag != NO_TAG) {
+		this->stats.evictions++;
+	}
+	l->tag = tag;
+	l->valid = 0;
+	l->dirty = 0;
+	if(this->streaming) {
+		//streamed lines enter as the next victim so they never push hot lines out
+#if SERIALRAM_CACHE_POLICY == SERIALRAM_CACHE_LRU
+		l->stamp = 0;
+#elif SERIALRAM_CACHE_POLICY == SERIALRAM_CACHE_CLOCK
+		l->referenced = false;
+		this->next = victim;
+#else
+		this->next = victim;
+#endif
+	}
+	else {
+		this->touch(l);
+	}
+	return l;
+}
+
+int8_t SerialRAMCache::selectVictim() {
+#if SERIALRAM_CACHE_POLICY == SERIALRAM_CACHE_LRU
+	int8_t victim = -1;
+	for(uint8_t i = 0; i < SERIALRAM_CACHE_LINES; i++) {
+		line* l = &this->lines[i];
+		if(l->tag != NO_TAG && this->isPinned(l->tag)) {
+			continue;
+		}
+		if(victim < 0 || l->tag == NO_TAG || l->stamp < this->lines[victim].stamp) {
+			victim = i;
+			if(l->tag == NO_TAG) {
+				break;
+			}
+		}
+	}
+	return victim;
+#elif SERIALRAM_CACHE_POLICY == SERIALRAM_CACHE_CLOCK
+	//two turns of the hand clear every reference bit, so a victim is found if one is not pinned
+	for(uint8_t turn = 0; turn < 2 * SERIALRAM_CACHE_LINES; turn++) {
+		uint8_t i = this->next;
+		line* l = &this->lines[i];
+		this->next = (this->next + 1) % SERIALRAM_CACHE_LINES;
+		if(l->tag != NO_TAG && this->isPinned(l->tag)) {
+			continue;
+		}
+		if(l->tag != NO_TAG && l->referenced) {
+			l->referenced = false;
+			continue;
+		}
+		return i;
+	}
+	return -1;
+#else
+	for(uint8_t turn = 0; turn < SERIALRAM_CACHE_LINES; turn++) {
+		uint8_t i = this->next;
+		this->next = (this->next + 1) % SERIALRAM_CACHE_LINES;
+		if(this->lines[i].tag == NO_TAG || !this->isPinned(this->lines[i].tag)) {
+			return i;
+		}
+	}
+	return -1;
+#endif
+}
+
+void SerialRAMCache::touch(line* l) {
+#if SERIALRAM_CACHE_POLICY == SERIALRAM_CACHE_LRU
+	if(++this->clock == 0) {
+		//stamps wrapped: restart every line from the same age
+		for(uint8_t i = 0; i < SERIALRAM_CACHE_LINES; i++) {
+			this->lines[i].stamp = 0;
+		}
+		this->clock = 1;
+	}
+	l->stamp = this->clock;
+#elif SERIALRAM_CACHE_POLICY == SERIALRAM_CACHE_CLOCK
+	l->referenced = true;
+#else
+	(void)l;
+#endif
+}
+
+bool SerialRAMCache::isPinned(const uint16_t tag) {
+	for(uint8_t i = 0; i < this->pinCount; i++) {
+		if(tag >= this->pins[i].first && tag <= this->pins[i].last) {
+			return true;
+		}
+	}
+	return false;
+}
+
+uint8_t SerialRAMCache::fetch(line* l) {
+	uint8_t buffer[SERIALRAM_CHUNK_SIZE];
+	uint8_t status = this->ram->read(l->tag * SERIALRAM_CHUNK_SIZE, buffer, SERIALRAM_CHUNK_SIZE);
+	if(status) {
+		return status;
+	}
+	//bytes written in the cache are newer than the chip
+	for(uint8_t i = 0; i < SERIALRAM_CHUNK_SIZE; i++) {
+		if(!(l->dirty & (1UL << i))) {
+			l->data[i] = buffer[i];
+		}
+	}
+	l->valid = LINE_FULL;
+	return 0;
+}
+
+uint8_t SerialRAMCache::writeBack(line* l) {
+	if(!l->dirty) {
+		return 0;
+	}
+	uint8_t first = 0;
+	uint8_t last = SERIALRAM_CHUNK_SIZE - 1;
+	while(!(l->dirty & (1UL << first))) {
+		first++;
+	}
+	while(!(l->dirty & (1UL << last))) {
+		last--;
+	}
+	//the span is written in one transaction, holes in it must hold the chip content
+	uint32_t span = (LINE_FULL >> (SERIALRAM_CHUNK_SIZE - 1 - last)) & (LINE_FULL << first);
+	if((l->valid & span) != span) {
+		uint8_t status = this->fetch(l);
+		if(status) {
+			return status;
+		}
+	}
+	uint8_t status = this->ram->write(l->tag * SERIALRAM_CHUNK_SIZE + first, l->data + first, last - first + 1);
+	if(status) {
+		return status;
+	}
+	this->stats.writeBacks++;
+	l->dirty = 0;
+	return 0;
+}
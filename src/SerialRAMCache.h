@@ -0,0 +1,133 @@
+/*
+	SerialRAMCache.h
+	Small write back cache in front of a SerialRAM chip, with array style access through a proxy reference
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#ifndef _SerialRAMCache_h
+#define _SerialRAMCache_h
+
+#include "SerialRAM.h"
+
+//Number of cache lines. Each line holds SERIALRAM_CHUNK_SIZE bytes aligned on a chunk boundary.
+#ifndef SERIALRAM_CACHE_LINES
+	#define SERIALRAM_CACHE_LINES 2
+#endif
+
+//Replacement policies, select one by defining SERIALRAM_CACHE_POLICY in the build flags
+#define SERIALRAM_CACHE_ROUND_ROBIN 0
+#define SERIALRAM_CACHE_LRU 1
+#define SERIALRAM_CACHE_CLOCK 2
+
+#ifndef SERIALRAM_CACHE_POLICY
+	#define SERIALRAM_CACHE_POLICY SERIALRAM_CACHE_ROUND_ROBIN
+#endif
+
+//Largest number of pinned address ranges
+#ifndef SERIALRAM_CACHE_PINS
+	#define SERIALRAM_CACHE_PINS 2
+#endif
+
+#if SERIALRAM_CHUNK_SIZE > 32
+	#error "SerialRAMCache tracks line bytes in a 32 bit mask, SERIALRAM_CHUNK_SIZE must be 32 or less"
+#endif
+
+class SerialRAMCache;
+
+typedef struct {
+	uint32_t hits;
+	uint32_t misses;
+	uint32_t evictions;
+	uint32_t writeBacks;
+	uint32_t bypasses;
+} SerialRAMCacheStats;
+
+//Stands for one byte of the chip: reading it or assigning to it goes through the cache
+class SerialRAMRef {
+private:
+	SerialRAMCache* cache;
+	uint16_t address;
+
+public:
+	SerialRAMRef(SerialRAMCache* cache, const uint16_t address);
+
+	operator uint8_t() const;
+	SerialRAMRef& operator=(const uint8_t value);
+	SerialRAMRef& operator=(const SerialRAMRef& other);
+	SerialRAMRef& operator+=(const uint8_t value);
+	SerialRAMRef& operator-=(const uint8_t value);
+	SerialRAMRef& operator|=(const uint8_t value);
+	SerialRAMRef& operator&=(const uint8_t value);
+	SerialRAMRef& operator^=(const uint8_t value);
+	SerialRAMRef& operator++();
+	SerialRAMRef& operator--();
+};
+
+class SerialRAMCache {
+private:
+	typedef struct {
+		uint16_t tag;
+		uint32_t valid;
+		uint32_t dirty;
+#if SERIALRAM_CACHE_POLICY == SERIALRAM_CACHE_LRU
+		uint16_t stamp;
+#elif SERIALRAM_CACHE_POLICY == SERIALRAM_CACHE_CLOCK
+		bool referenced;
+#endif
+		uint8_t data[SERIALRAM_CHUNK_SIZE];
+	} line;
+
+	typedef struct {
+		uint16_t first;
+		uint16_t last;
+	} pinRange;
+
+	SerialRAM* ram;
+	line lines[SERIALRAM_CACHE_LINES];
+	//round robin position or clock hand
+	uint8_t next;
+	uint8_t status;
+#if SERIALRAM_CACHE_POLICY == SERIALRAM_CACHE_LRU
+	uint16_t clock;
+#endif
+	pinRange pins[SERIALRAM_CACHE_PINS];
+	uint8_t pinCount;
+	bool streaming;
+	SerialRAMCacheStats stats;
+
+	line* lookup(const uint16_t tag);
+	line* allocate(const uint16_t tag, uint8_t* status);
+	int8_t selectVictim();
+	void touch(line* l);
+	bool isPinned(const uint16_t tag);
+	uint8_t fetch(line* l);
+	uint8_t writeBack(line* l);
+
+public:
+	SerialRAMCache(SerialRAM& ram);
+
+	SerialRAMRef operator[](const uint16_t address);
+	uint8_t get(const uint16_t address);
+	uint8_t set(const uint16_t address, const uint8_t value);
+
+	uint8_t read(const uint16_t address, uint8_t* values, const uint16_t size);
+	uint8_t write(const uint16_t address, const uint8_t* values, const uint16_t size);
+
+	uint8_t flush();
+	uint8_t flush(const uint16_t address, const uint16_t size);
+	void invalidate();
+	uint8_t getStatus();
+	SerialRAM& device();
+
+	bool pin(const uint16_t address, const uint16_t size);
+	void unpin();
+	void setStreaming(const bool streaming);
+
+	SerialRAMCacheStats getStatistics();
+	void resetStatistics();
+};
+
+#endif
@@ -0,0 +1,106 @@
+/*
+	SerialRAMCheckpoint.cpp
+	Incremental checkpointing of a host structure into a SerialRAM chip, writing only the blocks that changed
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#include <stdint.h>
+#include "SerialRAMCheckpoint.h"
+#include "SerialRAMCrc.h"
+
+
+///<summary>
+///	Checkpoint the host structure "data" of "size" bytes into the device range starting at "address".
+///	<param name="ram">initialized SerialRAM chip</param>
+///	<param name="address">16 bit address of the checkpoint</param>
+///	<param name="data">host structure to checkpoint</param>
+///	<param name="size">size of the structure in bytes</param>
+///	<param name="hashes">array of SERIALRAM_CHECKPOINT_BLOCKS(size) entries holding the hash of each stored block</param>
+///</summary>
+SerialRAMCheckpoint::SerialRAMCheckpoint(SerialRAM& ram, const uint16_t address, void* data, const uint16_t size, uint16_t* hashes) {
+	this->ram = &ram;
+	this->address = address;
+	this->data = (uint8_t*)data;
+	this->size = size;
+	this->hashes = hashes;
+	this->primed = false;
+	this->written = 0;
+}
+
+///<summary>
+///	Store the structure. The first call writes every block, later calls hash each block of the structure
+///	and only write the blocks whose hash differs from the stored one, runs of changed blocks being merged into one write.
+///		<returns>same as SerialRAM::write()</returns>
+///</summary>
+uint8_t SerialRAMCheckpoint::checkpoint() {
+	uint16_t blocks = SERIALRAM_CHECKPOINT_BLOCKS(this->size);
+	uint16_t runStart = 0;
+	uint16_t runLength = 0;
+	this->written = 0;
+	for(uint16_t b = 0; b <= blocks; b++) {
+		bool changed = false;
+		if(b < blocks) {
+			uint16_t offset = b * SERIALRAM_CHECKPOINT_BLOCK;
+			uint16_t length = this->size - offset < SERIALRAM_CHECKPOINT_BLOCK ? this->size - offset : SERIALRAM_CHECKPOINT_BLOCK;
+			uint16_t hash = serialRAMCrc16(this->data + offset, length);
+			changed = !this->primed || hash != this->hashes[b];
+			if(changed) {
+				if(!runLength) {
+					runStart = offset;
+				}
+				runLength += length;
+				this->hashes[b] = hash;
+				this->written++;
+			}
+		}
+		if(!changed && runLength) {
+			uint8_t status = this->ram->write(this->address + runStart, this->data + runStart, runLength);
+			if(status) {
+				//the stored content is unknown now, start over with a full checkpoint
+				this->primed = false;
+				return status;
+			}
+			runLength = 0;
+		}
+	}
+	this->primed = true;
+	return 0;
+}
+
+///<summary>
+///	Load the structure back from the chip, for instance at boot, and prime the block hashes from it
+///	so the next checkpoint() only writes what changed afterwards.
+///		<returns>same as SerialRAM::read()</returns>
+///</summary>
+uint8_t SerialRAMCheckpoint::restore() {
+	uint8_t status = this->ram->read(this->address, this->data, this->size);
+	if(status) {
+		this->primed = false;
+		return status;
+	}
+	uint16_t blocks = SERIALRAM_CHECKPOINT_BLOCKS(this->size);
+	for(uint16_t b = 0; b < blocks; b++) {
+		uint16_t offset = b * SERIALRAM_CHECKPOINT_BLOCK;
+		uint16_t length = this->size - offset < SERIALRAM_CHECKPOINT_BLOCK ? this->size - offset : SERIALRAM_CHECKPOINT_BLOCK;
+		this->hashes[b] = serialRAMCrc16(this->data + offset, length);
+	}
+	this->primed = true;
+	return 0;
+}
+
+///<summary>
+///	Forget the stored hashes, the next checkpoint() writes the whole structure.
+///</summary>
+void SerialRAMCheckpoint::invalidate() {
+	this->primed = false;
+}
+
+///<summary>
+///	Number of blocks written by the last checkpoint().
+///</summary>
+uint16_t SerialRAMCheckpoint::blocksWritten() {
+	return this->written;
+}
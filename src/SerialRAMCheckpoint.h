@@ -0,0 +1,42 @@
+/*
+	SerialRAMCheckpoint.h
+	Incremental checkpointing of a host structure into a SerialRAM chip, writing only the blocks that changed
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#ifndef _SerialRAMCheckpoint_h
+#define _SerialRAMCheckpoint_h
+
+#include "SerialRAM.h"
+
+//Size in bytes of the blocks compared between checkpoints. One block fits one bus transaction by default.
+#ifndef SERIALRAM_CHECKPOINT_BLOCK
+	#define SERIALRAM_CHECKPOINT_BLOCK SERIALRAM_CHUNK_SIZE
+#endif
+
+//Number of hashes to allocate for a structure of "size" bytes
+#define SERIALRAM_CHECKPOINT_BLOCKS(size) (((size) + SERIALRAM_CHECKPOINT_BLOCK - 1) / SERIALRAM_CHECKPOINT_BLOCK)
+
+class SerialRAMCheckpoint {
+private:
+	SerialRAM* ram;
+	uint16_t address;
+	uint8_t* data;
+	uint16_t size;
+	uint16_t* hashes;
+	bool primed;
+	uint16_t written;
+
+public:
+	SerialRAMCheckpoint(SerialRAM& ram, const uint16_t address, void* data, const uint16_t size, uint16_t* hashes);
+
+	uint8_t checkpoint();
+	uint8_t restore();
+	void invalidate();
+	uint16_t blocksWritten();
+};
+
+#endif
@@ -0,0 +1,205 @@
+/*
+	SerialRAMCompress.cpp
+	Streaming delta + varint compression of integer series stored in a SerialRAM chip
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#include <stdint.h>
+#include "SerialRAMCompress.h"
+
+
+///<summary>
+///	Encode "delta" as a zigzag varint: small positive and negative values take a single byte.
+///		<param name="out">buffer of at least SERIALRAM_VARINT_MAX bytes</param>
+///		<param name="delta">signed value to encode</param>
+///		<returns>number of bytes written to out (1 to 5)</returns>
+///</summary>
+uint8_t SerialRAMCompressor::encode(uint8_t* out, const int32_t delta) {
+	uint32_t v = ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+	uint8_t n = 0;
+	while(v >= 0x80) {
+		out[n++] = (uint8_t)v | 0x80;
+		v >>= 7;
+	}
+	out[n++] = (uint8_t)v;
+	return n;
+}
+
+///<summary>
+///	Decode one zigzag varint written by encode().
+///		<param name="in">encoded bytes</param>
+///		<param name="available">number of bytes readable from in</param>
+///		<param name="delta">decoded value</param>
+///		<returns>number of bytes consumed, or 0 if the encoding is incomplete or invalid</returns>
+///</summary>
+uint8_t SerialRAMCompressor::decode(const uint8_t* in, const uint8_t available, int32_t* delta) {
+	uint32_t v = 0;
+	for(uint8_t i = 0; i < available && i < SERIALRAM_VARINT_MAX; i++) {
+		v |= (uint32_t)(in[i] & 0x7f) << (7 * i);
+		if(!(in[i] & 0x80)) {
+			*delta = (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+			return i + 1;
+		}
+	}
+	return 0;
+}
+
+///<summary>
+///	Compress into the device range [address, address + size).
+///		Only one SERIALRAM_CHUNK_SIZE window of host RAM is used, and each full window costs a single bulk write.
+///	<param name="ram">initialized SerialRAM chip</param>
+///	<param name="address">16 bit address of the compressed stream</param>
+///	<param name="size">maximum size of the compressed stream in bytes</param>
+///</summary>
+SerialRAMCompressor::SerialRAMCompressor(SerialRAM& ram, const uint16_t address, const uint16_t size) {
+	this->ram = &ram;
+	this->address = address;
+	this->size = size;
+	this->reset();
+}
+
+///<summary>
+///	Restart the stream at the beginning of the range. Nothing is written to the chip.
+///</summary>
+void SerialRAMCompressor::reset() {
+	this->position = 0;
+	this->previous = 0;
+	this->used = 0;
+}
+
+///<summary>
+///	Append one value, stored as the difference with the previous one.
+///		<returns>0:success, 1-4 : same as SerialRAM::write(), 5 : range full, value not written</returns>
+///</summary>
+uint8_t SerialRAMCompressor::write(const int32_t value) {
+	uint8_t encoded[SERIALRAM_VARINT_MAX];
+	uint8_t n = encode(encoded, (int32_t)((uint32_t)value - this->previous));
+	if(this->position + this->used + n > this->size) {
+		return 5;
+	}
+	if(this->used + n > SERIALRAM_CHUNK_SIZE) {
+		uint8_t status = this->flush();
+		if(status) {
+			return status;
+		}
+	}
+	memcpy(this->window + this->used, encoded, n);
+	this->used += n;
+	this->previous = (uint32_t)value;
+	return 0;
+}
+
+///<summary>
+///	Append "count" values.
+///		<returns>same as write(value), stops at the first error</returns>
+///</summary>
+uint8_t SerialRAMCompressor::write(const int32_t* values, const uint16_t count) {
+	for(uint16_t i = 0; i < count; i++) {
+		uint8_t status = this->write(values[i]);
+		if(status) {
+			return status;
+		}
+	}
+	return 0;
+}
+
+///<summary>
+///	Write the pending window to the chip. Call it before reading the stream back or losing power.
+///		<returns>same as SerialRAM::write()</returns>
+///</summary>
+uint8_t SerialRAMCompressor::flush() {
+	if(!this->used) {
+		return 0;
+	}
+	uint8_t status = this->ram->write(this->address + this->position, this->window, this->used);
+	if(status) {
+		return status;
+	}
+	this->position += this->used;
+	this->used = 0;
+	return 0;
+}
+
+///<summary>
+///	Compressed size of the stream so far, pending window included.
+///		<returns>number of bytes to give to SerialRAMDecompressor</returns>
+///</summary>
+uint16_t SerialRAMCompressor::length() {
+	return this->position + this->used;
+}
+
+
+///<summary>
+///	Decompress the stream of "length" bytes written by a SerialRAMCompressor at "address".
+///	<param name="ram">initialized SerialRAM chip</param>
+///	<param name="address">16 bit address of the compressed stream</param>
+///	<param name="length">compressed size, as returned by SerialRAMCompressor::length()</param>
+///</summary>
+SerialRAMDecompressor::SerialRAMDecompressor(SerialRAM& ram, const uint16_t address, const uint16_t length) {
+	this->ram = &ram;
+	this->address = address;
+	this->length = length;
+	this->reset();
+}
+
+///<summary>
+///	Restart decoding from the first value.
+///</summary>
+void SerialRAMDecompressor::reset() {
+	this->position = 0;
+	this->previous = 0;
+	this->used = 0;
+	this->cursor = 0;
+}
+
+///<summary>
+///	Decode the next value. A new chunk is fetched only when the window runs out.
+///		<returns>0:success, 1-4 : same as SerialRAM::read(), 5 : end of stream</returns>
+///</summary>
+uint8_t SerialRAMDecompressor::read(int32_t* value) {
+	int32_t delta;
+	uint8_t n = SerialRAMCompressor::decode(this->window + this->cursor, this->used - this->cursor, &delta);
+	if(!n) {
+		//keep the partial varint and refill the rest of the window
+		uint8_t left = this->used - this->cursor;
+		memmove(this->window, this->window + this->cursor, left);
+		uint16_t remaining = this->length - this->position;
+		uint8_t fetch = SERIALRAM_CHUNK_SIZE - left;
+		if(fetch > remaining) {
+			fetch = remaining;
+		}
+		if(!fetch) {
+			return 5;
+		}
+		uint8_t status = this->ram->read(this->address + this->position, this->window + left, fetch);
+		if(status) {
+			return status;
+		}
+		this->position += fetch;
+		this->used = left + fetch;
+		this->cursor = 0;
+		n = SerialRAMCompressor::decode(this->window, this->used, &delta);
+		if(!n) {
+			return 5;
+		}
+	}
+	this->cursor += n;
+	this->previous += (uint32_t)delta;
+	*value = (int32_t)this->previous;
+	return 0;
+}
+
+///<summary>
+///	Decode up to "count" values.
+///		<returns>number of values decoded</returns>
+///</summary>
+uint16_t SerialRAMDecompressor::read(int32_t* values, const uint16_t count) {
+	uint16_t i = 0;
+	while(i < count && this->read(&values[i]) == 0) {
+		i++;
+	}
+	return i;
+}
@@ -0,0 +1,60 @@
+/*
+	SerialRAMCompress.h
+	Streaming delta + varint compression of integer series stored in a SerialRAM chip
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#ifndef _SerialRAMCompress_h
+#define _SerialRAMCompress_h
+
+#include "SerialRAM.h"
+
+//Longest encoding of a 32 bit value
+#define SERIALRAM_VARINT_MAX 5
+
+class SerialRAMCompressor {
+private:
+	SerialRAM* ram;
+	uint16_t address;
+	uint16_t size;
+	uint16_t position;
+	uint32_t previous;
+	uint8_t window[SERIALRAM_CHUNK_SIZE];
+	uint8_t used;
+
+public:
+	SerialRAMCompressor(SerialRAM& ram, const uint16_t address, const uint16_t size);
+
+	void reset();
+	uint8_t write(const int32_t value);
+	uint8_t write(const int32_t* values, const uint16_t count);
+	uint8_t flush();
+	uint16_t length();
+
+	static uint8_t encode(uint8_t* out, const int32_t delta);
+	static uint8_t decode(const uint8_t* in, const uint8_t available, int32_t* delta);
+};
+
+class SerialRAMDecompressor {
+private:
+	SerialRAM* ram;
+	uint16_t address;
+	uint16_t length;
+	uint16_t position;
+	uint32_t previous;
+	uint8_t window[SERIALRAM_CHUNK_SIZE];
+	uint8_t used;
+	uint8_t cursor;
+
+public:
+	SerialRAMDecompressor(SerialRAM& ram, const uint16_t address, const uint16_t length);
+
+	void reset();
+	uint8_t read(int32_t* value);
+	uint16_t read(int32_t* values, const uint16_t count);
+};
+
+#endif
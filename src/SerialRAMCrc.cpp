@@ -0,0 +1,31 @@
+/*
+	SerialRAMCrc.cpp
+	CRC-16/CCITT used to fingerprint blocks of data stored in a SerialRAM chip
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#include "SerialRAMCrc.h"
+
+
+///<summary>
+///	CRC-16/CCITT (polynomial 0x1021) of "size" bytes, computed a nibble at a time from a 16 entry table.
+///		Pass the previous result as "crc" to continue a CRC over data received in several pieces.
+///		<param name="data">bytes to fingerprint</param>
+///		<param name="size">number of bytes</param>
+///		<param name="crc">initial value, 0xFFFF for a new CRC</param>
+///		<returns>updated CRC</returns>
+///</summary>
+uint16_t serialRAMCrc16(const uint8_t* data, const uint16_t size, uint16_t crc) {
+	static const uint16_t table[16] = {
+		0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7,
+		0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef
+	};
+	for(uint16_t i = 0; i < size; i++) {
+		crc = (crc << 4) ^ table[(crc >> 12) ^ (data[i] >> 4)];
+		crc = (crc << 4) ^ table[(crc >> 12) ^ (data[i] & 0x0f)];
+	}
+	return crc;
+}
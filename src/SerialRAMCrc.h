@@ -0,0 +1,17 @@
+/*
+	SerialRAMCrc.h
+	CRC-16/CCITT used to fingerprint blocks of data stored in a SerialRAM chip
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#ifndef _SerialRAMCrc_h
+#define _SerialRAMCrc_h
+
+#include <stdint.h>
+
+uint16_t serialRAMCrc16(const uint8_t* data, const uint16_t size, uint16_t crc = 0xffff);
+
+#endif
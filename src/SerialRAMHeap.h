@@ -0,0 +1,298 @@
+/*
+	SerialRAMHeap.h
+	Persistent binary min-heap of keyed entries stored in a SerialRAM chip, with a host mirror of the keys
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#ifndef _SerialRAMHeap_h
+#define _SerialRAMHeap_h
+
+#include "SerialRAM.h"
+#include "SerialRAMCrc.h"
+
+//Bytes of each of the two header copies besides the payload of the entry being sifted:
+//sequence (1), entry count (2), hole (2), sift direction (1), key of the entry being sifted (4), crc16 (2)
+#define SERIALRAM_HEAP_HEADER_COPY 12
+
+//Direction of the sift recorded in the header
+#define SERIALRAM_HEAP_SIFT_NONE 0
+#define SERIALRAM_HEAP_SIFT_UP 1
+#define SERIALRAM_HEAP_SIFT_DOWN 2
+
+//Min-heap of up to N entries, each a 32 bit key (for instance a due time) and a payload T.
+//Comparisons only use the host copy of the keys, the chip is only touched for the slots that move.
+//The entry being inserted or removed floats in the header while the others move, so every step is published by a header write
+//and begin() finishes a sift cut short by a reset.
+//The region used on the chip is 2 * (SERIALRAM_HEAP_HEADER_COPY + sizeof(T)) + N * (4 + sizeof(T)) bytes.
+template<typename T, uint16_t N>
+class SerialRAMHeap {
+private:
+	static const uint16_t ENTRY = 4 + sizeof(T);
+	static const uint16_t COPY = SERIALRAM_HEAP_HEADER_COPY + sizeof(T);
+
+	SerialRAM* ram;
+	uint16_t address;
+	uint16_t count;
+	uint32_t keys[N];
+	uint8_t sequence;
+	//while a sift runs, slot "hole" holds nothing and "floating" holds the entry that will fill it
+	uint16_t hole;
+	uint8_t sift;
+	uint8_t floating[ENTRY];
+
+	uint16_t slotAddress(const uint16_t slot) {
+		return this->address + 2 * COPY + slot * ENTRY;
+	}
+
+	static uint32_t unpackKey(const uint8_t* bytes) {
+		return bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+	}
+
+	uint8_t loadHeader(const uint8_t copy, uint8_t* header) {
+		uint8_t status = this->ram->read(this->address + copy * COPY, header, COPY);
+		if(status) {
+			return status;
+		}
+		uint16_t crc = serialRAMCrc16(header, COPY - 2);
+		if((header[COPY - 2] | (header[COPY - 1] << 8)) != crc || (header[0] & 1) != copy) {
+			return 6;
+		}
+		return 0;
+	}
+
+	//write the other header copy, the host state only follows if the write succeeds
+	uint8_t writeHeader(const uint16_t count, const uint16_t hole, const uint8_t sift, const uint8_t* floating) {
+		uint8_t sequence = this->sequence + 1;
+		uint8_t header[COPY];
+		header[0] = sequence;
+		header[1] = count & 0xff;
+		header[2] = count >> 8;
+		header[3] = hole & 0xff;
+		header[4] = hole >> 8;
+		header[5] = sift;
+		memcpy(header + 6, floating, ENTRY);
+		uint16_t crc = serialRAMCrc16(header, COPY - 2);
+		header[COPY - 2] = crc & 0xff;
+		header[COPY - 1] = crc >> 8;
+		uint8_t status = this->ram->write(this->address + (sequence & 1) * COPY, header, COPY);
+		if(!status) {
+			this->sequence = sequence;
+			this->count = count;
+			this->hole = hole;
+			this->sift = sift;
+			memmove(this->floating, floating, ENTRY);
+		}
+		return status;
+	}
+
+	//copy a whole slot on the chip, key included, and mirror the key
+	uint8_t moveSlot(const uint16_t to, const uint16_t from) {
+		uint8_t status = this->ram->move(this->slotAddress(to), this->slotAddress(from), ENTRY);
+		if(!status) {
+			this->keys[to] = this->keys[from];
+		}
+		return status;
+	}
+
+	//move the hole up or down until the floating entry fits, then drop it in. Every step is redone safely after a reset.
+	uint8_t resume() {
+		uint32_t key = unpackKey(this->floating);
+		while(this->sift != SERIALRAM_HEAP_SIFT_NONE) {
+			uint16_t next = this->hole;
+			if(this->sift == SERIALRAM_HEAP_SIFT_UP) {
+				if(this->hole > 0 && this->keys[(this->hole - 1) / 2] > key) {
+					next = (this->hole - 1) / 2;
+				}
+			}
+			else {
+				uint16_t child = 2 * this->hole + 1;
+				if(child + 1 < this->count && this->keys[child + 1] < this->keys[child]) {
+					child++;
+				}
+				if(child < this->count && this->keys[child] < key) {
+					next = child;
+				}
+			}
+			uint8_t status;
+			if(next == this->hole) {
+				status = this->ram->write(this->slotAddress(this->hole), this->floating, ENTRY);
+				if(status) {
+					return status;
+				}
+				this->keys[this->hole] = key;
+				return this->writeHeader(this->count, 0, SERIALRAM_HEAP_SIFT_NONE, this->floating);
+			}
+			status = this->moveSlot(this->hole, next);
+			if(!status) {
+				status = this->writeHeader(this->count, next, this->sift, this->floating);
+			}
+			if(status) {
+				return status;
+			}
+		}
+		return 0;
+	}
+
+public:
+	///<summary>
+	///	Create a heap whose header lives at "address".
+	///	<param name="ram">initialized SerialRAM chip</param>
+	///	<param name="address">16 bit address of the heap header</param>
+	///</summary>
+	SerialRAMHeap(SerialRAM& ram, const uint16_t address) {
+		this->ram = &ram;
+		this->address = address;
+		this->count = 0;
+		this->sequence = 0;
+		this->hole = 0;
+		this->sift = SERIALRAM_HEAP_SIFT_NONE;
+		memset(this->floating, 0, ENTRY);
+	}
+
+	///<summary>
+	///	Load the newest valid header, mirror every key from the chip and finish a sift interrupted by a reset.
+	///		A chip without a valid header, or with an inconsistent one, is treated as an empty heap.
+	///		<returns>same as SerialRAM::read() and SerialRAM::write()</returns>
+	///</summary>
+	uint8_t begin() {
+		uint8_t headers[2][COPY];
+		bool valid[2];
+		for(uint8_t copy = 0; copy < 2; copy++) {
+			uint8_t status = this->loadHeader(copy, headers[copy]);
+			if(status && status != 6) {
+				return status;
+			}
+			valid[copy] = !status;
+		}
+		//sequences wrap around, the newer copy is the one exactly one step ahead
+		uint8_t* header = headers[valid[0] && (!valid[1] || (uint8_t)(headers[0][0] - headers[1][0]) == 1) ? 0 : 1];
+		if(!valid[0] && !valid[1]) {
+			memset(header, 0, COPY);
+		}
+		this->sequence = header[0];
+		this->count = header[1] | (header[2] << 8);
+		this->hole = header[3] | (header[4] << 8);
+		this->sift = header[5];
+		memcpy(this->floating, header + 6, ENTRY);
+		if(this->count > N || this->sift > SERIALRAM_HEAP_SIFT_DOWN || (this->sift != SERIALRAM_HEAP_SIFT_NONE && this->hole >= this->count)) {
+			this->count = 0;
+			this->sift = SERIALRAM_HEAP_SIFT_NONE;
+		}
+		for(uint16_t slot = 0; slot < this->count; slot++) {
+			uint8_t key[4];
+			uint8_t status = this->ram->read(this->slotAddress(slot), key, 4);
+			if(status) {
+				return status;
+			}
+			this->keys[slot] = unpackKey(key);
+		}
+		return this->resume();
+	}
+
+	uint16_t size() {
+		return this->count;
+	}
+
+	bool empty() {
+		return this->count == 0;
+	}
+
+	uint8_t clear() {
+		return this->writeHeader(0, 0, SERIALRAM_HEAP_SIFT_NONE, this->floating);
+	}
+
+	///<summary>
+	///	Smallest key, read from the host mirror without touching the bus.
+	///		Only meaningful if the heap is not empty and the last push() or pop() succeeded.
+	///</summary>
+	uint32_t topKey() {
+		return this->keys[0];
+	}
+
+	///<summary>
+	///	Insert an entry. The header write that records it is what publishes it, then parents larger than "key"
+	///	are moved down one slot each and the entry is written once in the freed slot.
+	///	A failed call may leave the sift pending, the next call or begin() finishes it.
+	///		<returns>0:success, 1-4 : same as SerialRAM::write(), 5 : heap full</returns>
+	///</summary>
+	uint8_t push(const uint32_t key, const T& payload) {
+		uint8_t status = this->resume();
+		if(status) {
+			return status;
+		}
+		if(this->count >= N) {
+			return 5;
+		}
+		uint8_t entry[ENTRY];
+		for(uint8_t i = 0; i < 4; i++) {
+			entry[i] = key >> (8 * i);
+		}
+		memcpy(entry + 4, &payload, sizeof(T));
+		status = this->writeHeader(this->count + 1, this->count, SERIALRAM_HEAP_SIFT_UP, entry);
+		if(status) {
+			return status;
+		}
+		return this->resume();
+	}
+
+	///<summary>
+	///	Remove the entry with the smallest key. The header write that takes the former last entry out of its slot
+	///	is what publishes the removal, then smaller children are moved up one slot each and that entry is written once in the freed slot.
+	///	A failed call may leave the sift pending, the next call or begin() finishes it.
+	///		<param name="key">key of the removed entry, may be null</param>
+	///		<param name="payload">payload of the removed entry, may be null</param>
+	///		<returns>0:success, 1-4 : same as SerialRAM::write(), 5 : heap empty</returns>
+	///</summary>
+	uint8_t pop(uint32_t* key = 0, T* payload = 0) {
+		uint8_t status = this->resume();
+		if(status) {
+			return status;
+		}
+		if(!this->count) {
+			return 5;
+		}
+		if(payload) {
+			status = this->ram->read(this->slotAddress(0) + 4, (uint8_t*)payload, sizeof(T));
+			if(status) {
+				return status;
+			}
+		}
+		if(key) {
+			*key = this->keys[0];
+		}
+		uint16_t last = this->count - 1;
+		if(!last) {
+			return this->writeHeader(0, 0, SERIALRAM_HEAP_SIFT_NONE, this->floating);
+		}
+		uint8_t entry[ENTRY];
+		status = this->ram->read(this->slotAddress(last), entry, ENTRY);
+		if(status) {
+			return status;
+		}
+		status = this->writeHeader(last, 0, SERIALRAM_HEAP_SIFT_DOWN, entry);
+		if(status) {
+			return status;
+		}
+		return this->resume();
+	}
+
+	///<summary>
+	///	Copy the payload of the entry with the smallest key.
+	///		<returns>0:success, 1-4 : same as SerialRAM::read(), 5 : heap empty</returns>
+	///</summary>
+	uint8_t peek(T* payload) {
+		uint8_t status = this->resume();
+		if(status) {
+			return status;
+		}
+		if(!this->count) {
+			return 5;
+		}
+		return this->ram->read(this->slotAddress(0) + 4, (uint8_t*)payload, sizeof(T));
+	}
+};
+
+#endif
@@ -0,0 +1,280 @@
+/*
+	SerialRAMImage.cpp
+	Export and import of a SerialRAM image over any Arduino Stream, in CRC checked, optionally compressed, acknowledged frames
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#include <stdint.h>
+#include "SerialRAMImage.h"
+#include "SerialRAMCrc.h"
+
+//Frame: magic (2) sequence (2) address (2) flags (1) length (1) payload (length) crc16 (2), little endian.
+//The CRC covers everything from the magic to the end of the payload.
+#define MAGIC_LOW 0x49
+#define MAGIC_HIGH 0x52
+#define ACK 0x06
+#define NAK 0x15
+//PackBits payload of a full chunk in the worst case
+#define PACKED_MAX (SERIALRAM_CHUNK_SIZE + (SERIALRAM_CHUNK_SIZE + 127) / 128)
+
+#if PACKED_MAX > 255
+	#error "SerialRAMImage frames carry an 8 bit length, SERIALRAM_CHUNK_SIZE is too large"
+#endif
+
+
+//Counts CRC and bytes written when out is not null, only computes the packed size otherwise
+class PackedOutput {
+public:
+	Stream* out;
+	uint16_t* crc;
+	uint8_t size;
+
+	void put(const uint8_t value) {
+		if(this->out) {
+			this->out->write(value);
+			*this->crc = serialRAMCrc16(&value, 1, *this->crc);
+		}
+		this->size++;
+	}
+};
+
+///<summary>
+///	Transfer images through "stream", e.g. Serial.
+///		The image is cut in SERIALRAM_CHUNK_SIZE frames read straight from the chip, so a transfer needs one chunk
+///		of RAM whatever the image size. Every frame is acknowledged; send() remembers the last acknowledged frame
+///		and the next call resumes from there after a timeout or a reset of the receiver.
+///		Stream::setTimeout() sets how long to wait for an acknowledge or for the next byte of a frame.
+///	<param name="ram">initialized SerialRAM chip</param>
+///	<param name="stream">link to the other side</param>
+///</summary>
+SerialRAMImage::SerialRAMImage(SerialRAM& ram, Stream& stream) {
+	this->ram = &ram;
+	this->stream = &stream;
+	this->frame = 0;
+}
+
+///<summary>
+///	Export [address, address + size) from the next frame not acknowledged yet.
+///		Runs of equal bytes are PackBits compressed when "compress" is set and it makes the frame smaller.
+///	<param name="compress">allow compressed frames</param>
+///		<returns>0:success, 1-4 : same as SerialRAM::read(), 6 : a frame was not acknowledged after SERIALRAM_IMAGE_RETRIES attempts, call again with the same range to resume</returns>
+///</summary>
+uint8_t SerialRAMImage::send(const uint16_t address, const uint16_t size, const bool compress) {
+	uint8_t chunk[SERIALRAM_CHUNK_SIZE];
+	uint16_t frames = (size + SERIALRAM_CHUNK_SIZE - 1) / SERIALRAM_CHUNK_SIZE;
+	while(this->frame < frames) {
+		uint16_t offset = this->frame * SERIALRAM_CHUNK_SIZE;
+		uint8_t length = size - offset < SERIALRAM_CHUNK_SIZE ? size - offset : SERIALRAM_CHUNK_SIZE;
+		uint8_t status = this->ram->read(address + offset, chunk, length);
+		if(status) {
+			return status;
+		}
+		status = this->sendFrame(address + offset, chunk, length, this->frame + 1 == frames, compress);
+		if(status) {
+			return status;
+		}
+		this->frame++;
+	}
+	this->frame = 0;
+	return 0;
+}
+
+///<summary>
+///	Import frames into the chip until the last frame of an image. Every valid frame is written where its address says
+///	and acknowledged, so frames resent after a lost acknowledge or a resumed transfer are simply written again.
+///		<returns>0:success, 1-4 : same as SerialRAM::write(), 6 : timeout waiting for a frame</returns>
+///</summary>
+uint8_t SerialRAMImage::receive() {
+	uint8_t chunk[SERIALRAM_CHUNK_SIZE];
+	while(true) {
+		uint8_t value;
+		uint16_t crc = 0xffff;
+		//slide over the stream until the last two bytes are the magic, so a byte that breaks a match can still start one
+		uint8_t previous = 0;
+		while(true) {
+			if(!this->readByte(&value, &crc)) {
+				return 6;
+			}
+			if(previous == MAGIC_LOW && value == MAGIC_HIGH) {
+				break;
+			}
+			previous = value;
+		}
+		const uint8_t magic[2] = { MAGIC_LOW, MAGIC_HIGH };
+		crc = serialRAMCrc16(magic, sizeof(magic));
+		uint8_t header[6];
+		for(uint8_t i = 0; i < sizeof(header); i++) {
+			if(!this->readByte(&header[i], &crc)) {
+				return 6;
+			}
+		}
+		uint16_t sequence = header[0] | (header[1] << 8);
+		uint16_t address = header[2] | (header[3] << 8);
+		uint8_t flags = header[4];
+		uint8_t length = header[5];
+		//decode the payload on the fly, PackBits runs never need more than the chunk itself
+		uint8_t size = 0;
+		bool valid = length <= PACKED_MAX;
+		for(uint8_t read = 0; valid && read < length; ) {
+			if(!this->readByte(&value, &crc)) {
+				return 6;
+			}
+			read++;
+			if(!(flags & SERIALRAM_IMAGE_PACKED)) {
+				if(size >= SERIALRAM_CHUNK_SIZE) {
+					valid = false;
+					break;
+				}
+				chunk[size++] = value;
+				continue;
+			}
+			int8_t control = (int8_t)value;
+			if(control == -128) {
+				continue;
+			}
+			uint8_t count = control >= 0 ? control + 1 : 1 - control;
+			if(size + count > SERIALRAM_CHUNK_SIZE || read >= length) {
+				valid = false;
+				break;
+			}
+			for(uint8_t i = 0; i < (control >= 0 ? count : 1); i++) {
+				if(read >= length || !this->readByte(&value, &crc)) {
+					valid = false;
+					break;
+				}
+				read++;
+				chunk[size++] = value;
+			}
+			for(uint8_t i = 1; valid && control < 0 && i < count; i++) {
+				chunk[size++] = value;
+			}
+		}
+		if(!valid) {
+			this->reply(NAK, sequence);
+			continue;
+		}
+		uint8_t trailer[2];
+		uint16_t expected = crc;
+		if(this->stream->readBytes(trailer, 2) != 2) {
+			return 6;
+		}
+		if((trailer[0] | (trailer[1] << 8)) != expected) {
+			this->reply(NAK, sequence);
+			continue;
+		}
+		uint8_t status = this->ram->write(address, chunk, size);
+		if(status) {
+			return status;
+		}
+		this->reply(ACK, sequence);
+		if(flags & SERIALRAM_IMAGE_LAST) {
+			return 0;
+		}
+	}
+}
+
+///<summary>
+///	Index of the next frame send() will transmit, i.e. the number of frames acknowledged so far.
+///</summary>
+uint16_t SerialRAMImage::getFrame() {
+	return this->frame;
+}
+
+///<summary>
+///	Start the next send() from the first frame instead of resuming.
+///</summary>
+void SerialRAMImage::rewind() {
+	this->frame = 0;
+}
+
+//Emit the PackBits encoding of "values" to out, or only measure it when out is null
+uint8_t SerialRAMImage::pack(const uint8_t* values, const uint8_t size, Stream* out, uint16_t* crc) {
+	PackedOutput output;
+	output.out = out;
+	output.crc = crc;
+	output.size = 0;
+	uint8_t i = 0;
+	while(i < size) {
+		uint8_t run = 1;
+		while(i + run < size && run < 128 && values[i + run] == values[i]) {
+			run++;
+		}
+		if(run >= 3) {
+			output.put((uint8_t)(1 - run));
+			output.put(values[i]);
+			i += run;
+			continue;
+		}
+		//literal up to the next run of 3 equal bytes
+		uint8_t literal = 0;
+		while(i + literal < size && literal < 128) {
+			if(i + literal + 2 < size && values[i + literal] == values[i + literal + 1] && values[i + literal] == values[i + literal + 2]) {
+				break;
+			}
+			literal++;
+		}
+		output.put(literal - 1);
+		for(uint8_t j = 0; j < literal; j++) {
+			output.put(values[i + j]);
+		}
+		i += literal;
+	}
+	return output.size;
+}
+
+uint8_t SerialRAMImage::sendFrame(const uint16_t address, const uint8_t* values, const uint8_t size, const bool last, const bool compress) {
+	uint8_t packed = compress ? pack(values, size, 0, 0) : 0xff;
+	bool usePacked = packed < size;
+	uint8_t header[8] = {
+		MAGIC_LOW, MAGIC_HIGH,
+		(uint8_t)(this->frame & 0xff), (uint8_t)(this->frame >> 8),
+		(uint8_t)(address & 0xff), (uint8_t)(address >> 8),
+		(uint8_t)((usePacked ? SERIALRAM_IMAGE_PACKED : 0) | (last ? SERIALRAM_IMAGE_LAST : 0)),
+		usePacked ? packed : size
+	};
+	for(uint8_t attempt = 0; attempt < SERIALRAM_IMAGE_RETRIES; attempt++) {
+		//drop stale acknowledges before sending
+		while(this->stream->available() > 0) {
+			this->stream->read();
+		}
+		uint16_t crc = serialRAMCrc16(header, sizeof(header));
+		this->stream->write(header, sizeof(header));
+		if(usePacked) {
+			pack(values, size, this->stream, &crc);
+		}
+		else {
+			this->stream->write(values, size);
+			crc = serialRAMCrc16(values, size, crc);
+		}
+		this->stream->write((uint8_t)(crc & 0xff));
+		this->stream->write((uint8_t)(crc >> 8));
+		if(this->waitAck(this->frame)) {
+			return 0;
+		}
+	}
+	return 6;
+}
+
+bool SerialRAMImage::waitAck(const uint16_t sequence) {
+	uint8_t answer[3];
+	if(this->stream->readBytes(answer, 3) != 3) {
+		return false;
+	}
+	return answer[0] == ACK && (answer[1] | (answer[2] << 8)) == sequence;
+}
+
+bool SerialRAMImage::readByte(uint8_t* value, uint16_t* crc) {
+	if(this->stream->readBytes(value, 1) != 1) {
+		return false;
+	}
+	*crc = serialRAMCrc16(value, 1, *crc);
+	return true;
+}
+
+void SerialRAMImage::reply(const uint8_t code, const uint16_t sequence) {
+	uint8_t answer[3] = { code, (uint8_t)(sequence & 0xff), (uint8_t)(sequence >> 8) };
+	this->stream->write(answer, 3);
+}
@@ -0,0 +1,45 @@
+/*
+	SerialRAMImage.h
+	Export and import of a SerialRAM image over any Arduino Stream, in CRC checked, optionally compressed, acknowledged frames
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#ifndef _SerialRAMImage_h
+#define _SerialRAMImage_h
+
+#include "SerialRAM.h"
+
+//Number of times a frame is sent before send() gives up
+#ifndef SERIALRAM_IMAGE_RETRIES
+	#define SERIALRAM_IMAGE_RETRIES 3
+#endif
+
+//Frame flags
+#define SERIALRAM_IMAGE_PACKED 0x01
+#define SERIALRAM_IMAGE_LAST 0x02
+
+class SerialRAMImage {
+private:
+	SerialRAM* ram;
+	Stream* stream;
+	uint16_t frame;
+
+	static uint8_t pack(const uint8_t* values, const uint8_t size, Stream* out, uint16_t* crc);
+	uint8_t sendFrame(const uint16_t address, const uint8_t* values, const uint8_t size, const bool last, const bool compress);
+	bool waitAck(const uint16_t sequence);
+	bool readByte(uint8_t* value, uint16_t* crc);
+	void reply(const uint8_t code, const uint16_t sequence);
+
+public:
+	SerialRAMImage(SerialRAM& ram, Stream& stream);
+
+	uint8_t send(const uint16_t address, const uint16_t size, const bool compress = true);
+	uint8_t receive();
+	uint16_t getFrame();
+	void rewind();
+};
+
+#endif
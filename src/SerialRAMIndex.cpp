@@ -0,0 +1,342 @@
+/*
+	SerialRAMIndex.cpp
+	Persistent sorted index (small fanout B+tree) of 16 bit keys and values stored in a SerialRAM chip
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#include <stdint.h>
+#include "SerialRAMIndex.h"
+
+
+///<summary>
+///	Create an index in the device range [address, address + size).
+///		Nodes are SERIALRAM_INDEX_NODE_SIZE bytes and hold up to SERIALRAM_INDEX_FANOUT entries, so a lookup
+///		reads one node per tree level, and inserting or updating a key rewrites only the nodes it touches.
+///	<param name="ram">initialized SerialRAM chip</param>
+///	<param name="address">16 bit address of the index header</param>
+///	<param name="size">size of the range in bytes</param>
+///</summary>
+SerialRAMIndex::SerialRAMIndex(SerialRAM& ram, const uint16_t address, const uint16_t size) {
+	this->ram = &ram;
+	this->address = address;
+	this->maxNodes = size > SERIALRAM_INDEX_HEADER_SIZE ? (size - SERIALRAM_INDEX_HEADER_SIZE) / SERIALRAM_INDEX_NODE_SIZE : 0;
+	this->root = 0;
+	this->nodes = 0;
+	this->height = 0;
+}
+
+///<summary>
+///	Load the index header from the chip. An invalid header is treated as an empty index.
+///		<returns>same as SerialRAM::read()</returns>
+///</summary>
+uint8_t SerialRAMIndex::begin() {
+	uint8_t header[SERIALRAM_INDEX_HEADER_SIZE];
+	uint8_t status = this->ram->read(this->address, header, SERIALRAM_INDEX_HEADER_SIZE);
+	if(status) {
+		return status;
+	}
+	this->root = header[0] | (header[1] << 8);
+	this->nodes = header[2] | (header[3] << 8);
+	this->height = header[4];
+	if(this->nodes > this->maxNodes || (this->nodes && (this->root >= this->nodes || !this->height))) {
+		this->root = 0;
+		this->nodes = 0;
+		this->height = 0;
+	}
+	return 0;
+}
+
+///<summary>
+///	Remove every key.
+///		<returns>same as SerialRAM::write()</returns>
+///</summary>
+uint8_t SerialRAMIndex::clear() {
+	return this->writeHeader(0, 0, 0);
+}
+
+///<summary>
+///	Look "key" up, reading one node per tree level.
+///		<param name="key">key to look for</param>
+///		<param name="value">value stored with the key</param>
+///		<returns>0:success, 1-4 : same as SerialRAM::read(), 6 : key not found</returns>
+///</summary>
+uint8_t SerialRAMIndex::find(const uint16_t key, uint16_t* value) {
+	if(!this->nodes) {
+		return 6;
+	}
+	node n;
+	uint16_t number = this->root;
+	while(true) {
+		uint8_t status = this->readNode(number, &n);
+		if(status) {
+			return status;
+		}
+		if(!n.count || key < n.keys[0]) {
+			return 6;
+		}
+		uint8_t slot = this->childSlot(&n, key);
+		if(n.leaf) {
+			if(n.keys[slot] != key) {
+				return 6;
+			}
+			*value = n.values[slot];
+			return 0;
+		}
+		number = n.values[slot];
+	}
+}
+
+///<summary>
+///	Insert "key", or update its value if it is already present.
+///		Full nodes met on the way down are split first, so the insertion never has to walk back up.
+///		<returns>0:success, 1-4 : same as SerialRAM::write(), 5 : no room left for the nodes a split may need</returns>
+///</summary>
+uint8_t SerialRAMIndex::insert(const uint16_t key, const uint16_t value) {
+	node x;
+	uint8_t status;
+	if(!this->nodes) {
+		if(!this->maxNodes) {
+			return 5;
+		}
+		x.count = 1;
+		x.leaf = 1;
+		x.keys[0] = key;
+		x.values[0] = value;
+		status = this->writeNode(0, &x);
+		if(status) {
+			return status;
+		}
+		return this->writeHeader(0, 1, 1);
+	}
+	//worst case: one split per level plus a new root
+	if(this->nodes + this->height + 1 > this->maxNodes) {
+		return 5;
+	}
+	uint16_t xNumber = this->root;
+	status = this->readNode(xNumber, &x);
+	if(status) {
+		return status;
+	}
+
+	if(x.count == SERIALRAM_INDEX_FANOUT) {
+		node top, sibling;
+		uint16_t siblingNumber;
+		uint16_t topNumber = this->nodes;
+		top.count = 1;
+		top.leaf = 0;
+		top.keys[0] = x.keys[0];
+		top.values[0] = xNumber;
+		//the new root is published with the old one as its only child before the split truncates it
+		status = this->writeNode(topNumber, &top);
+		if(status) {
+			return status;
+		}
+		status = this->writeHeader(topNumber, this->nodes + 1, this->height + 1);
+		if(status) {
+			return status;
+		}
+		status = this->splitChild(&top, topNumber, 0, &x, &sibling, &siblingNumber);
+		if(status) {
+			return status;
+		}
+		x = top;
+		xNumber = topNumber;
+	}
+
+	while(!x.leaf) {
+		bool dirty = false;
+		uint8_t slot = this->childSlot(&x, key);
+		if(key < x.keys[0]) {
+			//the first separator is the lower bound of the subtree
+			x.keys[0] = key;
+			dirty = true;
+		}
+		node child;
+		uint16_t childNumber = x.values[slot];
+		status = this->readNode(childNumber, &child);
+		if(status) {
+			return status;
+		}
+		if(child.count == SERIALRAM_INDEX_FANOUT) {
+			node sibling;
+			uint16_t siblingNumber;
+			status = this->splitChild(&x, xNumber, slot, &child, &sibling, &siblingNumber);
+			if(status) {
+				return status;
+			}
+			dirty = false;
+			if(key >= sibling.keys[0]) {
+				child = sibling;
+				childNumber = siblingNumber;
+			}
+		}
+		if(dirty) {
+			status = this->writeNode(xNumber, &x);
+			if(status) {
+				return status;
+			}
+		}
+		x = child;
+		xNumber = childNumber;
+	}
+
+	uint8_t position = 0;
+	while(position < x.count && x.keys[position] < key) {
+		position++;
+	}
+	if(position < x.count && x.keys[position] == key) {
+		x.values[position] = value;
+	}
+	else {
+		for(uint8_t i = x.count; i > position; i--) {
+			x.keys[i] = x.keys[i - 1];
+			x.values[i] = x.values[i - 1];
+		}
+		x.keys[position] = key;
+		x.values[position] = value;
+		x.count++;
+	}
+	//splits already persisted the header
+	return this->writeNode(xNumber, &x);
+}
+
+///<summary>
+///	Call "callback" for every key with from <= key <= to, in increasing key order.
+///		Only the subtrees whose key span overlaps the range are read.
+///		<returns>number of matching keys</returns>
+///</summary>
+uint16_t SerialRAMIndex::range(const uint16_t from, const uint16_t to, SerialRAMIndexCallback callback, void* context) {
+	if(!this->nodes || from > to) {
+		return 0;
+	}
+	return this->range(this->root, from, to, callback, context);
+}
+
+///<summary>
+///	Number of nodes used on the chip.
+///</summary>
+uint16_t SerialRAMIndex::nodeCount() {
+	return this->nodes;
+}
+
+uint16_t SerialRAMIndex::range(const uint16_t number, const uint16_t from, const uint16_t to, SerialRAMIndexCallback callback, void* context) {
+	node n;
+	uint16_t matches = 0;
+	if(this->readNode(number, &n)) {
+		return 0;
+	}
+	for(uint8_t i = 0; i < n.count; i++) {
+		if(n.leaf) {
+			if(n.keys[i] >= from && n.keys[i] <= to) {
+				callback(n.keys[i], n.values[i], context);
+				matches++;
+			}
+			continue;
+		}
+		//child i holds keys in [keys[i], keys[i + 1])
+		bool below = i + 1 < n.count && n.keys[i + 1] <= from;
+		bool above = n.keys[i] > to;
+		if(above) {
+			break;
+		}
+		if(!below) {
+			matches += this->range(n.values[i], from, to, callback, context);
+		}
+	}
+	return matches;
+}
+
+uint8_t SerialRAMIndex::childSlot(const node* n, const uint16_t key) {
+	uint8_t slot = n->count - 1;
+	while(slot > 0 && n->keys[slot] > key) {
+		slot--;
+	}
+	return slot;
+}
+
+uint8_t SerialRAMIndex::splitChild(node* parent, const uint16_t parentNumber, const uint8_t slot, node* child, node* sibling, uint16_t* siblingNumber) {
+	uint8_t half = SERIALRAM_INDEX_FANOUT / 2;
+	uint16_t childNumber = parent->values[slot];
+	sibling->leaf = child->leaf;
+	sibling->count = child->count - half;
+	for(uint8_t i = 0; i < sibling->count; i++) {
+		sibling->keys[i] = child->keys[half + i];
+		sibling->values[i] = child->values[half + i];
+	}
+	child->count = half;
+	*siblingNumber = this->nodes;
+
+	for(uint8_t i = parent->count; i > slot + 1; i--) {
+		parent->keys[i] = parent->keys[i - 1];
+		parent->values[i] = parent->values[i - 1];
+	}
+	parent->keys[slot + 1] = sibling->keys[0];
+	parent->values[slot + 1] = *siblingNumber;
+	parent->count++;
+
+	//the allocation is persisted first so a reset cannot hand out the sibling again once the parent points to it,
+	//then the sibling, the parent pointing to it and the truncated child: the tree stays searchable at every step
+	uint8_t status = this->writeHeader(this->root, this->nodes + 1, this->height);
+	if(!status) {
+		status = this->writeNode(*siblingNumber, sibling);
+	}
+	if(!status) {
+		status = this->writeNode(parentNumber, parent);
+	}
+	if(!status) {
+		status = this->writeNode(childNumber, child);
+	}
+	return status;
+}
+
+uint16_t SerialRAMIndex::nodeAddress(const uint16_t number) {
+	return this->address + SERIALRAM_INDEX_HEADER_SIZE + number * SERIALRAM_INDEX_NODE_SIZE;
+}
+
+uint8_t SerialRAMIndex::readNode(const uint16_t number, node* n) {
+	uint8_t buffer[2 + 4 * SERIALRAM_INDEX_FANOUT];
+	uint8_t status = this->ram->read(this->nodeAddress(number), buffer, sizeof(buffer));
+	if(status) {
+		return status;
+	}
+	n->count = buffer[0] > SERIALRAM_INDEX_FANOUT ? SERIALRAM_INDEX_FANOUT : buffer[0];
+	n->leaf = buffer[1];
+	for(uint8_t i = 0; i < SERIALRAM_INDEX_FANOUT; i++) {
+		n->keys[i] = buffer[2 + 2 * i] | (buffer[3 + 2 * i] << 8);
+		n->values[i] = buffer[2 + 2 * SERIALRAM_INDEX_FANOUT + 2 * i] | (buffer[3 + 2 * SERIALRAM_INDEX_FANOUT + 2 * i] << 8);
+	}
+	return 0;
+}
+
+uint8_t SerialRAMIndex::writeNode(const uint16_t number, const node* n) {
+	uint8_t buffer[2 + 4 * SERIALRAM_INDEX_FANOUT];
+	buffer[0] = n->count;
+	buffer[1] = n->leaf;
+	for(uint8_t i = 0; i < SERIALRAM_INDEX_FANOUT; i++) {
+		buffer[2 + 2 * i] = n->keys[i] & 0xff;
+		buffer[3 + 2 * i] = n->keys[i] >> 8;
+		buffer[2 + 2 * SERIALRAM_INDEX_FANOUT + 2 * i] = n->values[i] & 0xff;
+		buffer[3 + 2 * SERIALRAM_INDEX_FANOUT + 2 * i] = n->values[i] >> 8;
+	}
+	return this->ram->write(this->nodeAddress(number), buffer, sizeof(buffer));
+}
+
+//write the header, the host copy only follows once it is on the chip
+uint8_t SerialRAMIndex::writeHeader(const uint16_t root, const uint16_t nodes, const uint8_t height) {
+	uint8_t header[SERIALRAM_INDEX_HEADER_SIZE];
+	header[0] = root & 0xff;
+	header[1] = root >> 8;
+	header[2] = nodes & 0xff;
+	header[3] = nodes >> 8;
+	header[4] = height;
+	uint8_t status = this->ram->write(this->address, header, SERIALRAM_INDEX_HEADER_SIZE);
+	if(!status) {
+		this->root = root;
+		this->nodes = nodes;
+		this->height = height;
+	}
+	return status;
+}
@@ -0,0 +1,63 @@
+/*
+	SerialRAMIndex.h
+	Persistent sorted index (small fanout B+tree) of 16 bit keys and values stored in a SerialRAM chip
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#ifndef _SerialRAMIndex_h
+#define _SerialRAMIndex_h
+
+#include "SerialRAM.h"
+
+//Size in bytes of a tree node on the chip. Reading a node costs SERIALRAM_INDEX_NODE_SIZE / SERIALRAM_CHUNK_SIZE transactions.
+#ifndef SERIALRAM_INDEX_NODE_SIZE
+	#define SERIALRAM_INDEX_NODE_SIZE (2 * SERIALRAM_CHUNK_SIZE)
+#endif
+
+//Node: entry count (1), leaf flag (1), then FANOUT keys and FANOUT values (or child node numbers)
+#define SERIALRAM_INDEX_FANOUT ((SERIALRAM_INDEX_NODE_SIZE - 2) / 4)
+
+//Index header: root node (2), allocated nodes (2), tree height (1)
+#define SERIALRAM_INDEX_HEADER_SIZE 5
+
+typedef void (*SerialRAMIndexCallback)(const uint16_t key, const uint16_t value, void* context);
+
+class SerialRAMIndex {
+private:
+	typedef struct {
+		uint8_t count;
+		uint8_t leaf;
+		uint16_t keys[SERIALRAM_INDEX_FANOUT];
+		uint16_t values[SERIALRAM_INDEX_FANOUT];
+	} node;
+
+	SerialRAM* ram;
+	uint16_t address;
+	uint16_t maxNodes;
+	uint16_t root;
+	uint16_t nodes;
+	uint8_t height;
+
+	uint16_t nodeAddress(const uint16_t number);
+	uint8_t readNode(const uint16_t number, node* n);
+	uint8_t writeNode(const uint16_t number, const node* n);
+	uint8_t writeHeader(const uint16_t root, const uint16_t nodes, const uint8_t height);
+	uint8_t splitChild(node* parent, const uint16_t parentNumber, const uint8_t slot, node* child, node* sibling, uint16_t* siblingNumber);
+	uint8_t childSlot(const node* n, const uint16_t key);
+	uint16_t range(const uint16_t number, const uint16_t from, const uint16_t to, SerialRAMIndexCallback callback, void* context);
+
+public:
+	SerialRAMIndex(SerialRAM& ram, const uint16_t address, const uint16_t size);
+
+	uint8_t begin();
+	uint8_t clear();
+	uint8_t find(const uint16_t key, uint16_t* value);
+	uint8_t insert(const uint16_t key, const uint16_t value);
+	uint16_t range(const uint16_t from, const uint16_t to, SerialRAMIndexCallback callback, void* context = 0);
+	uint16_t nodeCount();
+};
+
+#endif
@@ -0,0 +1,115 @@
+/*
+	SerialRAMIterator.h
+	Random access iterators over a range of a SerialRAM chip, going through a SerialRAMCache
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#ifndef _SerialRAMIterator_h
+#define _SerialRAMIterator_h
+
+#include "SerialRAMCache.h"
+
+//AVR cores ship without the standard library, the iterator category is only declared where <iterator> exists
+#if defined(__has_include)
+	#if __has_include(<iterator>)
+		#include <iterator>
+		#define SERIALRAM_HAS_STL_ITERATOR
+	#endif
+#endif
+
+//Iterator over chip addresses. Dereferencing yields a SerialRAMRef, so algorithms read and write through the cache lines.
+class SerialRAMIterator {
+private:
+	SerialRAMCache* owner;
+	uint16_t position;
+
+public:
+#ifdef SERIALRAM_HAS_STL_ITERATOR
+	typedef std::random_access_iterator_tag iterator_category;
+#endif
+	typedef uint8_t value_type;
+	typedef int16_t difference_type;
+	typedef SerialRAMRef reference;
+	typedef void pointer;
+
+	SerialRAMIterator() : owner(0), position(0) {}
+	SerialRAMIterator(SerialRAMCache& cache, const uint16_t address) : owner(&cache), position(address) {}
+
+	SerialRAMCache& cache() const { return *this->owner; }
+	uint16_t address() const { return this->position; }
+
+	SerialRAMRef operator*() const { return (*this->owner)[this->position]; }
+	SerialRAMRef operator[](const difference_type n) const { return (*this->owner)[this->position + n]; }
+
+	SerialRAMIterator& operator++() { this->position++; return *this; }
+	SerialRAMIterator& operator--() { this->position--; return *this; }
+	SerialRAMIterator operator++(int) { SerialRAMIterator it = *this; this->position++; return it; }
+	SerialRAMIterator operator--(int) { SerialRAMIterator it = *this; this->position--; return it; }
+	SerialRAMIterator& operator+=(const difference_type n) { this->position += n; return *this; }
+	SerialRAMIterator& operator-=(const difference_type n) { this->position -= n; return *this; }
+	SerialRAMIterator operator+(const difference_type n) const { return SerialRAMIterator(*this->owner, this->position + n); }
+	SerialRAMIterator operator-(const difference_type n) const { return SerialRAMIterator(*this->owner, this->position - n); }
+	difference_type operator-(const SerialRAMIterator& other) const { return (difference_type)(this->position - other.position); }
+
+	bool operator==(const SerialRAMIterator& other) const { return this->position == other.position; }
+	bool operator!=(const SerialRAMIterator& other) const { return this->position != other.position; }
+	bool operator<(const SerialRAMIterator& other) const { return this->position < other.position; }
+	bool operator>(const SerialRAMIterator& other) const { return this->position > other.position; }
+	bool operator<=(const SerialRAMIterator& other) const { return this->position <= other.position; }
+	bool operator>=(const SerialRAMIterator& other) const { return this->position >= other.position; }
+};
+
+inline SerialRAMIterator operator+(const SerialRAMIterator::difference_type n, const SerialRAMIterator& it) {
+	return it + n;
+}
+
+//Swapping two proxies swaps the chip bytes they stand for, which lets algorithms such as std::sort permute a range
+inline void swap(SerialRAMRef a, SerialRAMRef b) {
+	uint8_t value = a;
+	a = (uint8_t)b;
+	b = value;
+}
+
+//The range [address, address + size) of a chip, usable in range based for loops and with begin()/end() algorithms
+class SerialRAMRange {
+private:
+	SerialRAMCache* owner;
+	uint16_t first;
+	uint16_t size;
+
+public:
+	SerialRAMRange(SerialRAMCache& cache, const uint16_t address, const uint16_t size) : owner(&cache), first(address), size(size) {}
+
+	SerialRAMIterator begin() const { return SerialRAMIterator(*this->owner, this->first); }
+	SerialRAMIterator end() const { return SerialRAMIterator(*this->owner, this->first + this->size); }
+};
+
+//Copies between a chip range and contiguous host memory, found by argument dependent lookup for unqualified copy() calls
+//(write "using std::copy; copy(a, b, c);"). They bypass the per byte path and become chunked bulk transfers.
+//They return the end of the destination like std::copy, the optional "status" receives the SerialRAMCache::read() or write() result.
+inline uint8_t* copy(const SerialRAMIterator first, const SerialRAMIterator last, uint8_t* out, uint8_t* status = 0) {
+	uint16_t n = last.address() - first.address();
+	uint8_t result = first.cache().read(first.address(), out, n);
+	if(status) {
+		*status = result;
+	}
+	return out + n;
+}
+
+inline SerialRAMIterator copy(const uint8_t* first, const uint8_t* last, const SerialRAMIterator out, uint8_t* status = 0) {
+	uint16_t n = last - first;
+	uint8_t result = out.cache().write(out.address(), first, n);
+	if(status) {
+		*status = result;
+	}
+	return out + n;
+}
+
+inline SerialRAMIterator copy(uint8_t* first, uint8_t* last, const SerialRAMIterator out, uint8_t* status = 0) {
+	return copy((const uint8_t*)first, (const uint8_t*)last, out, status);
+}
+
+#endif
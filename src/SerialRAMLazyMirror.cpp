@@ -0,0 +1,175 @@
+/*
+	SerialRAMLazyMirror.cpp
+	Host RAM mirror of a SerialRAM region loaded on demand, chunk by chunk, with optional background prefetch
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#include <stdint.h>
+#include "SerialRAMLazyMirror.h"
+
+
+///<summary>
+///	Mirror the device range [address, address + size) in "buffer" without reading anything yet.
+///		Each SERIALRAM_CHUNK_SIZE piece is fetched the first time it is accessed, so setup() does not wait
+///		for the whole chip. Calling prefetch() from loop() fills the rest while the application runs.
+///	<param name="ram">initialized SerialRAM chip</param>
+///	<param name="address">16 bit address of the mirrored range</param>
+///	<param name="buffer">host buffer of at least size bytes</param>
+///	<param name="size">size of the range in bytes, up to 2048</param>
+///</summary>
+SerialRAMLazyMirror::SerialRAMLazyMirror(SerialRAM& ram, const uint16_t address, uint8_t* buffer, const uint16_t size) {
+	this->ram = &ram;
+	this->address = address;
+	this->buffer = buffer;
+	this->size = size > SERIALRAM_LAZY_MAX_CHUNKS * SERIALRAM_CHUNK_SIZE ? SERIALRAM_LAZY_MAX_CHUNKS * SERIALRAM_CHUNK_SIZE : size;
+	this->invalidate();
+}
+
+///<summary>
+///	Copy "size" bytes starting at the chip address "address", fetching the chunks not loaded yet.
+///		Runs of missing chunks are fetched with a single bulk read.
+///		<returns>0:success, 1-4 : same as SerialRAM::read(), 5 : range outside the mirror, 7 : chip busy with another transfer</returns>
+///</summary>
+uint8_t SerialRAMLazyMirror::read(const uint16_t address, void* values, const uint16_t size) {
+	uint8_t status = this->ensure(address, size);
+	if(status) {
+		return status;
+	}
+	memcpy(values, this->buffer + (address - this->address), size);
+	return 0;
+}
+
+///<summary>
+///	Write "size" bytes through to the chip and into the mirror. Chunks it does not cover entirely stay unloaded:
+///	the chip already holds the new bytes, so loading them later stays coherent.
+///		<returns>0:success, 1-4 : same as SerialRAM::write(), 5 : range outside the mirror</returns>
+///</summary>
+uint8_t SerialRAMLazyMirror::write(const uint16_t address, const void* values, const uint16_t size) {
+	if(!this->contains(address, size)) {
+		return 5;
+	}
+	uint8_t status = this->ram->write(address, (const uint8_t*)values, size);
+	if(status) {
+		return status;
+	}
+	uint16_t offset = address - this->address;
+	memcpy(this->buffer + offset, values, size);
+	for(uint16_t chunk = (offset + SERIALRAM_CHUNK_SIZE - 1) / SERIALRAM_CHUNK_SIZE; (chunk + 1) * SERIALRAM_CHUNK_SIZE <= offset + size; chunk++) {
+		if(!this->isChunkLoaded(chunk)) {
+			this->loaded[chunk >> 3] |= 1 << (chunk & 7);
+			this->loadedCount++;
+		}
+	}
+	return 0;
+}
+
+///<summary>
+///	Direct pointer to the mirrored bytes of [address, address + size), loading them if needed.
+///		Use it to read in place; changes made through the pointer are not written to the chip.
+///		<returns>pointer into the mirror buffer, or null if out of range or on bus error</returns>
+///</summary>
+const uint8_t* SerialRAMLazyMirror::data(const uint16_t address, const uint16_t size) {
+	if(this->ensure(address, size)) {
+		return 0;
+	}
+	return this->buffer + (address - this->address);
+}
+
+///<summary>
+///	Background fill: load the next "chunks" chunks not loaded yet, in one bulk read when they follow each other.
+///	Call it from loop() until isComplete() to bound the time taken from the application at each call.
+///		<returns>same as SerialRAM::read()</returns>
+///</summary>
+uint8_t SerialRAMLazyMirror::prefetch(const uint8_t chunks) {
+	uint16_t total = (this->size + SERIALRAM_CHUNK_SIZE - 1) / SERIALRAM_CHUNK_SIZE;
+	uint8_t budget = chunks;
+	while(budget && this->loadedCount < total) {
+		while(this->isChunkLoaded(this->cursor)) {
+			this->cursor = (this->cursor + 1) % total;
+		}
+		uint16_t run = this->cursor;
+		while(run + 1 < total && run + 1 - this->cursor < budget && !this->isChunkLoaded(run + 1)) {
+			run++;
+		}
+		uint8_t status = this->load(this->cursor, run);
+		if(status) {
+			return status;
+		}
+		budget -= run - this->cursor + 1;
+		this->cursor = (run + 1) % total;
+	}
+	return 0;
+}
+
+///<summary>
+///	Whether the whole range is loaded.
+///</summary>
+bool SerialRAMLazyMirror::isComplete() {
+	return this->loadedCount >= (this->size + SERIALRAM_CHUNK_SIZE - 1) / SERIALRAM_CHUNK_SIZE;
+}
+
+///<summary>
+///	Forget every loaded chunk, for instance after the chip was changed behind the mirror.
+///</summary>
+void SerialRAMLazyMirror::invalidate() {
+	memset(this->loaded, 0, sizeof(this->loaded));
+	this->loadedCount = 0;
+	this->cursor = 0;
+}
+
+bool SerialRAMLazyMirror::isChunkLoaded(const uint16_t chunk) {
+	return this->loaded[chunk >> 3] & (1 << (chunk & 7));
+}
+
+uint8_t SerialRAMLazyMirror::load(const uint16_t firstChunk, const uint16_t lastChunk) {
+	uint16_t offset = firstChunk * SERIALRAM_CHUNK_SIZE;
+	uint16_t end = (lastChunk + 1) * SERIALRAM_CHUNK_SIZE;
+	if(end > this->size) {
+		end = this->size;
+	}
+	uint8_t status = this->ram->read(this->address + offset, this->buffer + offset, end - offset);
+	if(status) {
+		return status;
+	}
+	for(uint16_t chunk = firstChunk; chunk <= lastChunk; chunk++) {
+		this->loaded[chunk >> 3] |= 1 << (chunk & 7);
+	}
+	this->loadedCount += lastChunk - firstChunk + 1;
+	return 0;
+}
+
+bool SerialRAMLazyMirror::contains(const uint16_t address, const uint16_t size) {
+	return address >= this->address && size <= this->size && address - this->address <= this->size - size;
+}
+
+//load the missing chunks of [address, address + size)
+uint8_t SerialRAMLazyMirror::ensure(const uint16_t address, const uint16_t size) {
+	if(!this->contains(address, size)) {
+		return 5;
+	}
+	uint16_t offset = address - this->address;
+	if(size) {
+		uint16_t first = offset / SERIALRAM_CHUNK_SIZE;
+		uint16_t last = (offset + size - 1) / SERIALRAM_CHUNK_SIZE;
+		uint16_t chunk = first;
+		while(chunk <= last) {
+			if(this->isChunkLoaded(chunk)) {
+				chunk++;
+				continue;
+			}
+			uint16_t run = chunk;
+			while(run + 1 <= last && !this->isChunkLoaded(run + 1)) {
+				run++;
+			}
+			uint8_t status = this->load(chunk, run);
+			if(status) {
+				return status;
+			}
+			chunk = run + 1;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,56 @@
+/*
+	SerialRAMLazyMirror.h
+	Host RAM mirror of a SerialRAM region loaded on demand, chunk by chunk, with optional background prefetch
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#ifndef _SerialRAMLazyMirror_h
+#define _SerialRAMLazyMirror_h
+
+#include "SerialRAM.h"
+
+//Largest number of chunks tracked, enough for a whole 47x16 chip
+#define SERIALRAM_LAZY_MAX_CHUNKS (2048 / SERIALRAM_CHUNK_SIZE)
+
+class SerialRAMLazyMirror {
+private:
+	SerialRAM* ram;
+	uint16_t address;
+	uint8_t* buffer;
+	uint16_t size;
+	uint16_t cursor;
+	uint16_t loadedCount;
+	uint8_t loaded[(SERIALRAM_LAZY_MAX_CHUNKS + 7) / 8];
+
+	bool isChunkLoaded(const uint16_t chunk);
+	uint8_t load(const uint16_t firstChunk, const uint16_t lastChunk);
+	uint8_t ensure(const uint16_t address, const uint16_t size);
+	bool contains(const uint16_t address, const uint16_t size);
+
+public:
+	SerialRAMLazyMirror(SerialRAM& ram, const uint16_t address, uint8_t* buffer, const uint16_t size);
+
+	uint8_t read(const uint16_t address, void* values, const uint16_t size);
+	uint8_t write(const uint16_t address, const void* values, const uint16_t size);
+	const uint8_t* data(const uint16_t address, const uint16_t size);
+	uint8_t prefetch(const uint8_t chunks = 1);
+	bool isComplete();
+	void invalidate();
+
+	///<summary>
+	///	Value of type T at the chip address "address", loaded on first access. Zero if it cannot be loaded.
+	///</summary>
+	template<typename T>
+	T get(const uint16_t address) {
+		T value;
+		if(this->read(address, &value, sizeof(T))) {
+			memset(&value, 0, sizeof(T));
+		}
+		return value;
+	}
+};
+
+#endif
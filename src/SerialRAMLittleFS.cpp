@@ -0,0 +1,114 @@
+/*
+	SerialRAMLittleFS.cpp
+	littlefs block device over a bank of SerialRAM chips. Only compiled when littlefs (lfs.h) is installed.
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#include <stdint.h>
+#include "SerialRAMLittleFS.h"
+
+#ifdef SERIALRAM_HAS_LITTLEFS
+
+
+SerialRAMLittleFS::SerialRAMLittleFS() {
+	this->chipTotal = 0;
+}
+
+///<summary>
+///	Append an initialized chip to the bank. Chips are concatenated in the order they are added.
+///		<returns>index of the chip in the bank, -1 if the bank is full</returns>
+///</summary>
+int8_t SerialRAMLittleFS::add(SerialRAM& ram) {
+	if(this->chipTotal >= SERIALRAM_LFS_CHIPS) {
+		return -1;
+	}
+	this->chips[this->chipTotal] = &ram;
+	return this->chipTotal++;
+}
+
+///<summary>
+///	Total size of the bank in bytes.
+///</summary>
+uint32_t SerialRAMLittleFS::capacity() {
+	uint32_t total = 0;
+	for(uint8_t i = 0; i < this->chipTotal; i++) {
+		total += this->chips[i]->capacity();
+	}
+	return total;
+}
+
+///<summary>
+///	Fill "config" for lfs_mount()/lfs_format() on this bank.
+///		Erase is a no-op since EERAM is byte writable SRAM, and block_cycles is -1 since it does not wear out,
+///		so littlefs spends no time on erase or wear leveling. Reads and programs are sized to SERIALRAM_CHUNK_SIZE
+///		so each one is a single I2C transaction, and the littlefs caches use buffers owned by this object.
+///	<param name="config">configuration to fill, keep it alive as long as the filesystem is mounted</param>
+///</summary>
+void SerialRAMLittleFS::configure(struct lfs_config* config) {
+	memset(config, 0, sizeof(struct lfs_config));
+	config->context = this;
+	config->read = SerialRAMLittleFS::read;
+	config->prog = SerialRAMLittleFS::prog;
+	config->erase = SerialRAMLittleFS::erase;
+	config->sync = SerialRAMLittleFS::sync;
+	config->read_size = SERIALRAM_CHUNK_SIZE;
+	config->prog_size = SERIALRAM_CHUNK_SIZE;
+	config->block_size = SERIALRAM_LFS_BLOCK_SIZE;
+	config->block_count = this->capacity() / SERIALRAM_LFS_BLOCK_SIZE;
+	config->block_cycles = -1;
+	config->cache_size = SERIALRAM_LFS_CACHE_SIZE;
+	config->lookahead_size = SERIALRAM_LFS_LOOKAHEAD_SIZE;
+	config->read_buffer = this->readBuffer;
+	config->prog_buffer = this->progBuffer;
+	config->lookahead_buffer = this->lookaheadBuffer;
+}
+
+//Turn a bank offset into a chip and an address on that chip. Blocks never span two chips since the block size divides the chip size.
+uint8_t SerialRAMLittleFS::locate(uint32_t* address, SerialRAM** chip) {
+	for(uint8_t i = 0; i < this->chipTotal; i++) {
+		uint16_t size = this->chips[i]->capacity();
+		if(*address < size) {
+			*chip = this->chips[i];
+			return 0;
+		}
+		*address -= size;
+	}
+	return 5;
+}
+
+int SerialRAMLittleFS::read(const struct lfs_config* c, lfs_block_t block, lfs_off_t off, void* buffer, lfs_size_t size) {
+	SerialRAMLittleFS* self = (SerialRAMLittleFS*)c->context;
+	uint32_t address = block * c->block_size + off;
+	SerialRAM* chip;
+	if(self->locate(&address, &chip) || chip->read(address, (uint8_t*)buffer, size)) {
+		return LFS_ERR_IO;
+	}
+	return 0;
+}
+
+int SerialRAMLittleFS::prog(const struct lfs_config* c, lfs_block_t block, lfs_off_t off, const void* buffer, lfs_size_t size) {
+	SerialRAMLittleFS* self = (SerialRAMLittleFS*)c->context;
+	uint32_t address = block * c->block_size + off;
+	SerialRAM* chip;
+	if(self->locate(&address, &chip) || chip->write(address, (const uint8_t*)buffer, size)) {
+		return LFS_ERR_IO;
+	}
+	return 0;
+}
+
+int SerialRAMLittleFS::erase(const struct lfs_config* c, lfs_block_t block) {
+	(void)c;
+	(void)block;
+	return 0;
+}
+
+//Writes reach the chip SRAM when prog returns, and the chip saves it to EEPROM by itself on power loss
+int SerialRAMLittleFS::sync(const struct lfs_config* c) {
+	(void)c;
+	return 0;
+}
+
+#endif
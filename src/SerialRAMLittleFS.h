@@ -0,0 +1,68 @@
+/*
+	SerialRAMLittleFS.h
+	littlefs block device over a bank of SerialRAM chips. Only compiled when littlefs (lfs.h) is installed.
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#ifndef _SerialRAMLittleFS_h
+#define _SerialRAMLittleFS_h
+
+#if defined(__has_include)
+	#if __has_include(<lfs.h>)
+		#define SERIALRAM_HAS_LITTLEFS
+	#endif
+#endif
+
+#ifdef SERIALRAM_HAS_LITTLEFS
+
+#include "SerialRAM.h"
+#include <lfs.h>
+
+//Largest number of chips in the bank
+#ifndef SERIALRAM_LFS_CHIPS
+	#define SERIALRAM_LFS_CHIPS 4
+#endif
+
+//Filesystem block size. Must be a power of two dividing the chip size, the default 256 bytes fits both 47x04 and 47x16 chips.
+#ifndef SERIALRAM_LFS_BLOCK_SIZE
+	#define SERIALRAM_LFS_BLOCK_SIZE 256
+#endif
+
+//Size of the littlefs read and program caches, a multiple of SERIALRAM_CHUNK_SIZE dividing the block size
+#ifndef SERIALRAM_LFS_CACHE_SIZE
+	#define SERIALRAM_LFS_CACHE_SIZE (4 * SERIALRAM_CHUNK_SIZE)
+#endif
+
+//Size of the block allocator lookahead buffer in bytes, a multiple of 8
+#ifndef SERIALRAM_LFS_LOOKAHEAD_SIZE
+	#define SERIALRAM_LFS_LOOKAHEAD_SIZE 8
+#endif
+
+class SerialRAMLittleFS {
+private:
+	SerialRAM* chips[SERIALRAM_LFS_CHIPS];
+	uint8_t chipTotal;
+	uint8_t readBuffer[SERIALRAM_LFS_CACHE_SIZE];
+	uint8_t progBuffer[SERIALRAM_LFS_CACHE_SIZE];
+	uint8_t lookaheadBuffer[SERIALRAM_LFS_LOOKAHEAD_SIZE];
+
+	uint8_t locate(uint32_t* address, SerialRAM** chip);
+	static int read(const struct lfs_config* c, lfs_block_t block, lfs_off_t off, void* buffer, lfs_size_t size);
+	static int prog(const struct lfs_config* c, lfs_block_t block, lfs_off_t off, const void* buffer, lfs_size_t size);
+	static int erase(const struct lfs_config* c, lfs_block_t block);
+	static int sync(const struct lfs_config* c);
+
+public:
+	SerialRAMLittleFS();
+
+	int8_t add(SerialRAM& ram);
+	uint32_t capacity();
+	void configure(struct lfs_config* config);
+};
+
+#endif
+
+#endif
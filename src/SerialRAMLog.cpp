@@ -0,0 +1,397 @@
+/*
+	SerialRAMLog.cpp
+	Append only key/record log stored in a SerialRAM chip, with incremental compaction of superseded records
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#include <stdint.h>
+#include "SerialRAMLog.h"
+#include "SerialRAMCrc.h"
+
+#define NONE 0xffff
+
+
+///<summary>
+///	Log of records appended to [address, address + size). Appending a record for a key supersedes the previous ones,
+///	which stay on the chip as garbage until compaction.
+///		Compaction slides the live records down with device side moves, a bounded amount per compactStep() call.
+///		While it runs the header describes a gap [gap start, gap end) between the compacted records and the ones
+///		not visited yet, so the log stays readable at every step, also after a reset in the middle of a pass.
+///	<param name="ram">initialized SerialRAM chip</param>
+///	<param name="address">16 bit address of the log header</param>
+///	<param name="size">size of the log in bytes, header included</param>
+///</summary>
+SerialRAMLog::SerialRAMLog(SerialRAM& ram, const uint16_t address, const uint16_t size) {
+	this->ram = &ram;
+	this->address = address;
+	this->capacity = size > SERIALRAM_LOG_HEADER_SIZE ? size - SERIALRAM_LOG_HEADER_SIZE : 0;
+	this->end = 0;
+	this->gapStart = NONE;
+	this->gapEnd = NONE;
+	this->moving = 0;
+	this->sequence = 0;
+	memset(this->latest, 0xff, sizeof(this->latest));
+	memset(this->lengths, 0, sizeof(this->lengths));
+	memset(this->compacted, 0, sizeof(this->compacted));
+}
+
+///<summary>
+///	Load the header and rebuild the latest record table by walking the log. A header that does not make sense
+///	leaves the log empty. A record left half way across the gap by a reset is slid to its place first.
+///		<returns>0:success, 1-4 : same as SerialRAM::read(), 6 : corrupt record, the log is truncated before it</returns>
+///</summary>
+uint8_t SerialRAMLog::begin() {
+	uint8_t headers[2][SERIALRAM_LOG_HEADER_COPY];
+	bool valid[2];
+	for(uint8_t copy = 0; copy < 2; copy++) {
+		uint8_t status = this->loadHeader(copy, headers[copy]);
+		if(status && status != 6) {
+			return status;
+		}
+		valid[copy] = !status;
+	}
+	//sequences wrap around, the newer copy is the one exactly one step ahead
+	uint8_t* header = headers[valid[0] && (!valid[1] || (uint8_t)(headers[0][0] - headers[1][0]) == 1) ? 0 : 1];
+	if(!valid[0] && !valid[1]) {
+		//blank chip: empty log, no compaction running
+		memset(header, 0, SERIALRAM_LOG_HEADER_COPY);
+		memset(header + 3, 0xff, 4);
+	}
+	this->sequence = header[0];
+	this->end = header[1] | (header[2] << 8);
+	this->gapStart = header[3] | (header[4] << 8);
+	this->gapEnd = header[5] | (header[6] << 8);
+	this->moving = header[7] | (header[8] << 8);
+	bool idle = this->gapStart == NONE && this->gapEnd == NONE;
+	if(this->end > this->capacity || (!idle && (this->gapStart > this->gapEnd || this->gapEnd > this->end || this->moving > this->gapStart))
+		|| (idle && this->moving)) {
+		this->end = 0;
+		this->gapStart = NONE;
+		this->gapEnd = NONE;
+		this->moving = 0;
+	}
+	uint8_t status = this->resume();
+	if(status) {
+		return status;
+	}
+	return this->scan();
+}
+
+///<summary>
+///	Remove every record.
+///		<returns>same as SerialRAM::write()</returns>
+///</summary>
+uint8_t SerialRAMLog::clear() {
+	this->end = 0;
+	this->gapStart = NONE;
+	this->gapEnd = NONE;
+	this->moving = 0;
+	memset(this->latest, 0xff, sizeof(this->latest));
+	memset(this->lengths, 0, sizeof(this->lengths));
+	memset(this->compacted, 0, sizeof(this->compacted));
+	return this->writeHeader();
+}
+
+///<summary>
+///	Append a record for "key", superseding the previous one.
+///		<param name="key">0 to SERIALRAM_LOG_KEYS - 1</param>
+///		<param name="length">1 to 255 bytes</param>
+///		<returns>0:success, 1-4 : same as SerialRAM::write(), 5 : invalid key or length, or log full (compact it)</returns>
+///</summary>
+uint8_t SerialRAMLog::append(const uint8_t key, const uint8_t* values, const uint8_t length) {
+	if(!length) {
+		return 5;
+	}
+	return this->appendRecord(key, values, length);
+}
+
+///<summary>
+///	Append a removal marker for "key". Nothing is written if the key has no record.
+///		<returns>same as append()</returns>
+///</summary>
+uint8_t SerialRAMLog::remove(const uint8_t key) {
+	if(key >= SERIALRAM_LOG_KEYS) {
+		return 5;
+	}
+	if(this->latest[key] == NONE || !this->lengths[key]) {
+		return 0;
+	}
+	return this->appendRecord(key, 0, 0);
+}
+
+///<summary>
+///	Read the latest record of "key", one transaction per chunk thanks to the host table of record offsets.
+///		<param name="size">size of values, the record is truncated to it</param>
+///		<param name="length">when not null, receives the length of the record</param>
+///		<returns>0:success, 1-4 : same as SerialRAM::read(), 5 : invalid key, 6 : no record for key</returns>
+///</summary>
+uint8_t SerialRAMLog::read(const uint8_t key, uint8_t* values, const uint8_t size, uint8_t* length) {
+	if(key >= SERIALRAM_LOG_KEYS) {
+		return 5;
+	}
+	if(this->latest[key] == NONE || !this->lengths[key]) {
+		return 6;
+	}
+	if(length) {
+		*length = this->lengths[key];
+	}
+	uint8_t n = this->lengths[key] < size ? this->lengths[key] : size;
+	return this->ram->read(this->address + SERIALRAM_LOG_HEADER_SIZE + this->latest[key] + SERIALRAM_LOG_RECORD_HEADER, values, n);
+}
+
+///<summary>
+///	Start a compaction pass if none is running. The work itself is done by compactStep().
+///		<returns>same as SerialRAM::write()</returns>
+///</summary>
+uint8_t SerialRAMLog::compact() {
+	if(this->isCompacting()) {
+		return 0;
+	}
+	this->gapStart = 0;
+	this->gapEnd = 0;
+	memset(this->compacted, 0, sizeof(this->compacted));
+	return this->writeHeader();
+}
+
+///<summary>
+///	Advance the running compaction pass by about "budget" bytes of records, at least one record.
+///		A superseded record or a removal marker is dropped by widening the gap. A live record is moved down to the
+///		gap start, see slide(), so the header always describes a log that begin() can walk.
+///		When the gap reaches the end of the log the pass finishes and the gap becomes free space.
+///		Records appended during the pass are visited by it as well.
+///	<param name="budget">number of record bytes to visit in this call</param>
+///		<returns>0:success, 1-4 : same as SerialRAM::write()</returns>
+///</summary>
+uint8_t SerialRAMLog::compactStep(const uint16_t budget) {
+	uint16_t visited = 0;
+	uint8_t status = this->resume();
+	if(status) {
+		return status;
+	}
+	while(this->isCompacting() && (!visited || visited < budget)) {
+		if(this->gapEnd >= this->end) {
+			this->end = this->gapStart;
+			this->gapStart = NONE;
+			this->gapEnd = NONE;
+			return this->writeHeader();
+		}
+		uint8_t record[SERIALRAM_LOG_RECORD_HEADER];
+		uint16_t base = this->address + SERIALRAM_LOG_HEADER_SIZE;
+		status = this->ram->read(base + this->gapEnd, record, SERIALRAM_LOG_RECORD_HEADER);
+		if(status) {
+			return status;
+		}
+		uint8_t key = record[0];
+		uint16_t size = SERIALRAM_LOG_RECORD_HEADER + record[1];
+		bool live = this->latest[key] == this->gapEnd;
+		if(live && !record[1] && !this->compacted[key]) {
+			//the older records of the key were all dropped by this pass, the marker has nothing left to hide
+			this->latest[key] = NONE;
+			live = false;
+		}
+		if(live) {
+			uint16_t start = this->gapStart;
+			bool wasCompacted = this->compacted[key];
+			this->latest[key] = start;
+			this->compacted[key] = true;
+			status = this->slide(size);
+			if(status && this->gapStart == start) {
+				//nothing moved, the record is still the one at the gap end
+				this->latest[key] = this->gapEnd;
+				this->compacted[key] = wasCompacted;
+			}
+		}
+		else {
+			this->gapEnd += size;
+			status = this->writeHeader();
+		}
+		if(status) {
+			return status;
+		}
+		visited += size;
+	}
+	return 0;
+}
+
+///<summary>
+///	Whether a compaction pass is running.
+///</summary>
+bool SerialRAMLog::isCompacting() {
+	return this->gapEnd != NONE;
+}
+
+///<summary>
+///	Bytes taken by records on the chip, superseded ones included.
+///</summary>
+uint16_t SerialRAMLog::used() {
+	return this->isCompacting() ? this->end - (this->gapEnd - this->gapStart) : this->end;
+}
+
+///<summary>
+///	Bytes that a complete compaction would give back.
+///</summary>
+uint16_t SerialRAMLog::garbage() {
+	uint16_t live = 0;
+	for(uint8_t key = 0; key < SERIALRAM_LOG_KEYS; key++) {
+		if(this->latest[key] != NONE && this->lengths[key]) {
+			live += SERIALRAM_LOG_RECORD_HEADER + this->lengths[key];
+		}
+	}
+	return this->used() - live;
+}
+
+///<summary>
+///	Bytes left for appending.
+///</summary>
+uint16_t SerialRAMLog::available() {
+	return this->capacity - this->end;
+}
+
+//Write the header to the older copy, the CRC makes it the newest only once it is complete
+uint8_t SerialRAMLog::writeHeader() {
+	uint8_t sequence = this->sequence + 1;
+	uint8_t header[SERIALRAM_LOG_HEADER_COPY] = {
+		sequence,
+		(uint8_t)(this->end & 0xff), (uint8_t)(this->end >> 8),
+		(uint8_t)(this->gapStart & 0xff), (uint8_t)(this->gapStart >> 8),
+		(uint8_t)(this->gapEnd & 0xff), (uint8_t)(this->gapEnd >> 8),
+		(uint8_t)(this->moving & 0xff), (uint8_t)(this->moving >> 8),
+		0, 0
+	};
+	uint16_t crc = serialRAMCrc16(header, SERIALRAM_LOG_HEADER_COPY - 2);
+	header[SERIALRAM_LOG_HEADER_COPY - 2] = crc & 0xff;
+	header[SERIALRAM_LOG_HEADER_COPY - 1] = crc >> 8;
+	uint8_t status = this->ram->write(this->address + (sequence & 1) * SERIALRAM_LOG_HEADER_COPY, header, SERIALRAM_LOG_HEADER_COPY);
+	if(!status) {
+		this->sequence = sequence;
+	}
+	return status;
+}
+
+//Read one header copy, 6 when its CRC or sequence does not match
+uint8_t SerialRAMLog::loadHeader(const uint8_t copy, uint8_t* header) {
+	uint8_t status = this->ram->read(this->address + copy * SERIALRAM_LOG_HEADER_COPY, header, SERIALRAM_LOG_HEADER_COPY);
+	if(status) {
+		return status;
+	}
+	uint16_t crc = serialRAMCrc16(header, SERIALRAM_LOG_HEADER_COPY - 2);
+	if((header[SERIALRAM_LOG_HEADER_COPY - 2] | (header[SERIALRAM_LOG_HEADER_COPY - 1] << 8)) != crc || (header[0] & 1) != copy) {
+		return 6;
+	}
+	return 0;
+}
+
+//Move the record of "size" bytes at the gap end, of which "moving" bytes are already below the gap start, down
+//across the gap. When the gap is at least as wide as the rest of the record it goes in one move. Otherwise it goes in
+//pieces no larger than the gap, so a piece never overwrites bytes not copied yet, and the header is saved after each
+//piece: the bytes written always lie inside the gap of the last saved header, so a reset leaves a log begin() can finish.
+uint8_t SerialRAMLog::slide(const uint16_t size) {
+	uint16_t base = this->address + SERIALRAM_LOG_HEADER_SIZE;
+	while(this->moving < size) {
+		uint16_t gap = this->gapEnd - this->gapStart;
+		uint16_t piece = size - this->moving;
+		if(gap && piece > gap) {
+			piece = gap;
+		}
+		if(gap) {
+			uint8_t status = this->ram->move(base + this->gapStart, base + this->gapEnd, piece);
+			if(status) {
+				return status;
+			}
+		}
+		this->gapStart += piece;
+		this->gapEnd += piece;
+		this->moving = this->moving + piece < size ? this->moving + piece : 0;
+		uint8_t status = this->writeHeader();
+		if(status) {
+			return status;
+		}
+		if(!this->moving) {
+			break;
+		}
+	}
+	return 0;
+}
+
+//Finish sliding the record left across the gap by a reset or a bus error
+uint8_t SerialRAMLog::resume() {
+	if(!this->moving) {
+		return 0;
+	}
+	uint8_t record[SERIALRAM_LOG_RECORD_HEADER];
+	uint8_t status = this->ram->read(this->address + SERIALRAM_LOG_HEADER_SIZE + this->gapStart - this->moving, record, SERIALRAM_LOG_RECORD_HEADER);
+	if(status) {
+		return status;
+	}
+	uint16_t size = SERIALRAM_LOG_RECORD_HEADER + record[1];
+	if(this->moving >= size || this->gapEnd + size - this->moving > this->end) {
+		//cannot be the record being slid, drop everything from it on
+		this->end = this->gapStart - this->moving;
+		this->gapStart = NONE;
+		this->gapEnd = NONE;
+		this->moving = 0;
+		status = this->writeHeader();
+	}
+	else {
+		status = this->slide(size);
+	}
+	return status;
+}
+
+//Walk the records, skipping the compaction gap, to find the latest record of every key
+uint8_t SerialRAMLog::scan() {
+	memset(this->latest, 0xff, sizeof(this->latest));
+	memset(this->lengths, 0, sizeof(this->lengths));
+	memset(this->compacted, 0, sizeof(this->compacted));
+	uint16_t offset = 0;
+	while(offset < this->end) {
+		if(this->isCompacting() && offset == this->gapStart && this->gapStart != this->gapEnd) {
+			offset = this->gapEnd;
+			continue;
+		}
+		uint8_t record[SERIALRAM_LOG_RECORD_HEADER];
+		uint8_t status = this->ram->read(this->address + SERIALRAM_LOG_HEADER_SIZE + offset, record, SERIALRAM_LOG_RECORD_HEADER);
+		if(status) {
+			return status;
+		}
+		uint16_t next = offset + SERIALRAM_LOG_RECORD_HEADER + record[1];
+		if(record[0] >= SERIALRAM_LOG_KEYS || next > this->end || (this->isCompacting() && offset < this->gapStart && next > this->gapStart)) {
+			if(this->isCompacting() && offset < this->gapStart) {
+				this->gapStart = NONE;
+				this->gapEnd = NONE;
+			}
+			this->end = offset;
+			this->writeHeader();
+			return 6;
+		}
+		this->latest[record[0]] = offset;
+		this->lengths[record[0]] = record[1];
+		if(this->isCompacting() && offset < this->gapStart) {
+			this->compacted[record[0]] = true;
+		}
+		offset = next;
+	}
+	return 0;
+}
+
+uint8_t SerialRAMLog::appendRecord(const uint8_t key, const uint8_t* values, const uint8_t length) {
+	if(key >= SERIALRAM_LOG_KEYS || SERIALRAM_LOG_RECORD_HEADER + length > this->capacity - this->end) {
+		return 5;
+	}
+	uint16_t at = this->address + SERIALRAM_LOG_HEADER_SIZE + this->end;
+	uint8_t record[SERIALRAM_LOG_RECORD_HEADER] = { key, length };
+	uint8_t status = this->ram->write(at, record, SERIALRAM_LOG_RECORD_HEADER);
+	if(!status && length) {
+		status = this->ram->write(at + SERIALRAM_LOG_RECORD_HEADER, values, length);
+	}
+	if(status) {
+		return status;
+	}
+	this->latest[key] = this->end;
+	this->lengths[key] = length;
+	this->end += SERIALRAM_LOG_RECORD_HEADER + length;
+	return this->writeHeader();
+}
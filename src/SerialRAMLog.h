@@ -0,0 +1,69 @@
+/*
+	SerialRAMLog.h
+	Append only key/record log stored in a SerialRAM chip, with incremental compaction of superseded records
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#ifndef _SerialRAMLog_h
+#define _SerialRAMLog_h
+
+#include "SerialRAM.h"
+
+//Number of distinct keys, keys go from 0 to SERIALRAM_LOG_KEYS - 1. Costs 4 bytes of host RAM per key.
+#ifndef SERIALRAM_LOG_KEYS
+	#define SERIALRAM_LOG_KEYS 16
+#endif
+
+//Log header copy: sequence (1), end (2), gap start (2), gap end (2), bytes of the record being slid across the gap (2), crc16 (2)
+#define SERIALRAM_LOG_HEADER_COPY 11
+
+//The header is kept twice and updates alternate between both copies, so a torn header write leaves the previous one
+#define SERIALRAM_LOG_HEADER_SIZE (2 * SERIALRAM_LOG_HEADER_COPY)
+
+//Record header: key (1), length (1). A length of 0 marks the key as removed.
+#define SERIALRAM_LOG_RECORD_HEADER 2
+
+class SerialRAMLog {
+private:
+	SerialRAM* ram;
+	uint16_t address;
+	uint16_t capacity;
+	uint16_t end;
+	uint16_t gapStart;
+	uint16_t gapEnd;
+	uint16_t moving;
+	uint8_t sequence;
+	uint16_t latest[SERIALRAM_LOG_KEYS];
+	uint8_t lengths[SERIALRAM_LOG_KEYS];
+	//key has a record before the gap, set during a compaction pass
+	bool compacted[SERIALRAM_LOG_KEYS];
+
+	uint8_t writeHeader();
+	uint8_t loadHeader(const uint8_t copy, uint8_t* header);
+	uint8_t scan();
+	uint8_t slide(const uint16_t size);
+	uint8_t resume();
+	uint8_t appendRecord(const uint8_t key, const uint8_t* values, const uint8_t length);
+
+public:
+	SerialRAMLog(SerialRAM& ram, const uint16_t address, const uint16_t size);
+
+	uint8_t begin();
+	uint8_t clear();
+	uint8_t append(const uint8_t key, const uint8_t* values, const uint8_t length);
+	uint8_t remove(const uint8_t key);
+	uint8_t read(const uint8_t key, uint8_t* values, const uint8_t size, uint8_t* length = 0);
+
+	uint8_t compact();
+	uint8_t compactStep(const uint16_t budget);
+	bool isCompacting();
+
+	uint16_t used();
+	uint16_t garbage();
+	uint16_t available();
+};
+
+#endif
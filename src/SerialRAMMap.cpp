@@ -0,0 +1,394 @@
+/*
+	SerialRAMMap.cpp
+	Linux userspace only: memory mapped view of an EERAM image, flushing the modified pages through i2c-dev or an image file
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#if defined(__linux__) && !defined(ARDUINO)
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+#include "SerialRAMMap.h"
+#include "SerialRAMAddress.h"
+
+static struct sigaction previousHandler;
+static bool handlerInstalled = false;
+
+SerialRAMMap* SerialRAMMap::maps[SERIALRAM_MAP_MAX];
+
+
+SerialRAMI2CDevTransport::SerialRAMI2CDevTransport() {
+	this->fd = -1;
+	this->SRAM_REGISTER = SERIALRAM_SRAM_ADDRESS;
+	this->STORAGE_ARRAY_SIZE = 0x07;
+}
+
+SerialRAMI2CDevTransport::~SerialRAMI2CDevTransport() {
+	this->end();
+}
+
+///<summary>
+///	Open the I2C adapter "device" and address the chip strapped with A0 and A1, as SerialRAM::begin() does.
+///	<param name="device">adapter node, e.g. "/dev/i2c-1"</param>
+///	<param name="A0">A0 value (logic 0 or 1) of the RAM chip you want to address. Default value 0.</param>
+///	<param name="A1">A1 value (logic 0 or 1) of the RAM chip you want to address. Default value 0.</param>
+///	<param name="SIZE">Size of the chip in kbits. Acceptable values are 4 or 16. Default value 16.</param>
+///		<returns>0:success, 4 : the adapter cannot be opened, 5 : invalid size</returns>
+///</summary>
+uint8_t SerialRAMI2CDevTransport::begin(const char* device, const uint8_t A0, const uint8_t A1, const uint8_t SIZE) {
+	if(SIZE != 4 && SIZE != 16) {
+		return 5;
+	}
+	this->end();
+	this->SRAM_REGISTER = SERIALRAM_SRAM_ADDRESS | serialRAMAddressMask(A0, A1);
+	this->STORAGE_ARRAY_SIZE = SIZE == 4 ? 0x01 : 0x07;
+	this->fd = ::open(device, O_RDWR);
+	return this->fd < 0 ? 4 : 0;
+}
+
+void SerialRAMI2CDevTransport::end() {
+	if(this->fd >= 0) {
+		::close(this->fd);
+		this->fd = -1;
+	}
+}
+
+///<summary>
+///	Read with an address write followed by a repeated start read, in SERIALRAM_MAP_TRANSFER sized transactions.
+///		<returns>0:success, 4 : the I2C_RDWR ioctl failed</returns>
+///</summary>
+uint8_t SerialRAMI2CDevTransport::read(const uint16_t address, uint8_t* values, const uint16_t size) {
+	for(uint16_t done = 0; done < size; ) {
+		uint16_t n = size - done < SERIALRAM_MAP_TRANSFER ? size - done : SERIALRAM_MAP_TRANSFER;
+		uint16_t at = address + done;
+		uint8_t header[2] = { (uint8_t)((at >> 8) & this->STORAGE_ARRAY_SIZE), (uint8_t)(at & 0xff) };
+		struct i2c_msg messages[2];
+		messages[0].addr = this->SRAM_REGISTER;
+		messages[0].flags = 0;
+		messages[0].len = 2;
+		messages[0].buf = header;
+		messages[1].addr = this->SRAM_REGISTER;
+		messages[1].flags = I2C_M_RD;
+		messages[1].len = n;
+		messages[1].buf = values + done;
+		struct i2c_rdwr_ioctl_data transfer = { messages, 2 };
+		if(ioctl(this->fd, I2C_RDWR, &transfer) < 0) {
+			return 4;
+		}
+		done += n;
+	}
+	return 0;
+}
+
+///<summary>
+///	Write in SERIALRAM_MAP_TRANSFER sized transactions.
+///		<returns>0:success, 4 : the I2C_RDWR ioctl failed</returns>
+///</summary>
+uint8_t SerialRAMI2CDevTransport::write(const uint16_t address, const uint8_t* values, const uint16_t size) {
+	uint8_t buffer[SERIALRAM_MAP_TRANSFER + 2];
+	for(uint16_t done = 0; done < size; ) {
+		uint16_t n = size - done < SERIALRAM_MAP_TRANSFER ? size - done : SERIALRAM_MAP_TRANSFER;
+		uint16_t at = address + done;
+		buffer[0] = (at >> 8) & this->STORAGE_ARRAY_SIZE;
+		buffer[1] = at & 0xff;
+		memcpy(buffer + 2, values + done, n);
+		struct i2c_msg message;
+		message.addr = this->SRAM_REGISTER;
+		message.flags = 0;
+		message.len = n + 2;
+		message.buf = buffer;
+		struct i2c_rdwr_ioctl_data transfer = { &message, 1 };
+		if(ioctl(this->fd, I2C_RDWR, &transfer) < 0) {
+			return 4;
+		}
+		done += n;
+	}
+	return 0;
+}
+
+
+SerialRAMFileTransport::SerialRAMFileTransport() {
+	this->fd = -1;
+	this->size = 0;
+}
+
+SerialRAMFileTransport::~SerialRAMFileTransport() {
+	this->end();
+}
+
+///<summary>
+///	Use the file "path" as the chip image, creating it if needed and extending it to "size" bytes.
+///		<returns>0:success, 4 : the file cannot be opened or extended</returns>
+///</summary>
+uint8_t SerialRAMFileTransport::begin(const char* path, const uint16_t size) {
+	this->end();
+	this->fd = ::open(path, O_RDWR | O_CREAT, 0644);
+	if(this->fd < 0) {
+		return 4;
+	}
+	off_t length = lseek(this->fd, 0, SEEK_END);
+	if(length < size && ftruncate(this->fd, size) < 0) {
+		this->end();
+		return 4;
+	}
+	this->size = size;
+	return 0;
+}
+
+void SerialRAMFileTransport::end() {
+	if(this->fd >= 0) {
+		::close(this->fd);
+		this->fd = -1;
+	}
+}
+
+uint8_t SerialRAMFileTransport::read(const uint16_t address, uint8_t* values, const uint16_t size) {
+	if(size > this->size || address > this->size - size) {
+		return 5;
+	}
+	return pread(this->fd, values, size, address) == size ? 0 : 4;
+}
+
+uint8_t SerialRAMFileTransport::write(const uint16_t address, const uint8_t* values, const uint16_t size) {
+	if(size > this->size || address > this->size - size) {
+		return 5;
+	}
+	return pwrite(this->fd, values, size, address) == size ? 0 : 4;
+}
+
+
+SerialRAMMap::SerialRAMMap() {
+	this->transport = 0;
+	this->view = 0;
+	this->shadow = 0;
+	this->dirty = 0;
+	this->pageSize = 0;
+	this->mappedSize = 0;
+	this->size = 0;
+}
+
+SerialRAMMap::~SerialRAMMap() {
+	this->close();
+}
+
+///<summary>
+///	Map "size" bytes of the chip behind "transport" into the process and load them.
+///		The view is read only at the MMU level: the first store to a page faults, the fault handler marks the page
+///		dirty and unprotects it, and the store is replayed. sync() writes back only the dirty pages, and within
+///		them only the SERIALRAM_MAP_BLOCK sized blocks that differ from what was last loaded or flushed,
+///		since a whole 47x16 chip usually fits in one host page.
+///	<param name="transport">i2c-dev adapter or image file holding the chip contents</param>
+///	<param name="size">number of bytes mapped from address 0</param>
+///		<returns>0:success, 1-4 : same as the transport read, 5 : too many views mapped, 6 : mapping or signal handler setup failed</returns>
+///</summary>
+uint8_t SerialRAMMap::open(SerialRAMTransport& transport, const uint16_t size) {
+	this->close();
+	int8_t index = -1;
+	for(uint8_t i = 0; i < SERIALRAM_MAP_MAX; i++) {
+		if(!SerialRAMMap::maps[i]) {
+			index = i;
+			break;
+		}
+	}
+	if(index < 0) {
+		return 5;
+	}
+	if(!SerialRAMMap::installHandler()) {
+		return 6;
+	}
+	this->pageSize = sysconf(_SC_PAGESIZE);
+	size_t pages = (size + this->pageSize - 1) / this->pageSize;
+	this->mappedSize = pages * this->pageSize;
+	void* view = mmap(0, this->mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(view == MAP_FAILED) {
+		return 6;
+	}
+	this->view = (uint8_t*)view;
+	this->shadow = (uint8_t*)malloc(size);
+	this->dirty = (volatile uint8_t*)calloc(pages, 1);
+	if(!this->shadow || !this->dirty) {
+		this->close();
+		return 6;
+	}
+	uint8_t status = transport.read(0, this->view, size);
+	if(status) {
+		this->close();
+		return status;
+	}
+	memcpy(this->shadow, this->view, size);
+	this->transport = &transport;
+	this->size = size;
+	if(mprotect(this->view, this->mappedSize, PROT_READ)) {
+		this->close();
+		return 6;
+	}
+	SerialRAMMap::maps[index] = this;
+	return 0;
+}
+
+///<summary>
+///	Write the modified bytes back to the chip, like msync(). Pages are write protected again before being flushed,
+///	so stores made afterwards are caught by the next sync().
+///		<returns>0:success, 1-4 : same as the transport write, 6 : mapping not open or mprotect failed</returns>
+///</summary>
+uint8_t SerialRAMMap::sync() {
+	if(!this->transport) {
+		return 6;
+	}
+	size_t pages = this->mappedSize / this->pageSize;
+	for(size_t page = 0; page < pages; page++) {
+		if(!this->dirty[page]) {
+			continue;
+		}
+		//cleared before protecting, so a store faulting in between marks the page again instead of being forgotten
+		this->dirty[page] = 0;
+		if(mprotect(this->view + page * this->pageSize, this->pageSize, PROT_READ)) {
+			this->dirty[page] = 1;
+			return 6;
+		}
+		uint8_t status = this->flushPage(page);
+		if(status) {
+			//left dirty so the next sync() retries it. If the page stays read only, the next store faults and unprotects it again.
+			this->dirty[page] = 1;
+			(void)mprotect(this->view + page * this->pageSize, this->pageSize, PROT_READ | PROT_WRITE);
+			return status;
+		}
+	}
+	return 0;
+}
+
+///<summary>
+///	Flush and unmap the view. The pointer returned by data() is no longer valid afterwards.
+///		<returns>same as sync()</returns>
+///</summary>
+uint8_t SerialRAMMap::close() {
+	//a mapping that failed half way through open() has nothing to flush
+	uint8_t status = this->transport ? this->sync() : 0;
+	for(uint8_t i = 0; i < SERIALRAM_MAP_MAX; i++) {
+		if(SerialRAMMap::maps[i] == this) {
+			SerialRAMMap::maps[i] = 0;
+		}
+	}
+	if(this->view) {
+		munmap(this->view, this->mappedSize);
+	}
+	free(this->shadow);
+	free((void*)this->dirty);
+	this->view = 0;
+	this->shadow = 0;
+	this->dirty = 0;
+	this->transport = 0;
+	this->size = 0;
+	return status;
+}
+
+///<summary>
+///	Address of the first mapped byte, chip address 0. Null when nothing is mapped.
+///</summary>
+uint8_t* SerialRAMMap::data() {
+	return this->view;
+}
+
+uint16_t SerialRAMMap::length() {
+	return this->size;
+}
+
+///<summary>
+///	Number of pages modified since the last sync().
+///</summary>
+size_t SerialRAMMap::dirtyPages() {
+	size_t count = 0;
+	for(size_t page = 0; this->view && page < this->mappedSize / this->pageSize; page++) {
+		count += this->dirty[page] ? 1 : 0;
+	}
+	return count;
+}
+
+bool SerialRAMMap::installHandler() {
+	if(handlerInstalled) {
+		return true;
+	}
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_sigaction = SerialRAMMap::onFault;
+	action.sa_flags = SA_SIGINFO | SA_NODEFER;
+	sigemptyset(&action.sa_mask);
+	if(sigaction(SIGSEGV, &action, &previousHandler)) {
+		return false;
+	}
+	handlerInstalled = true;
+	return true;
+}
+
+//Faults outside every view are handed to the handler that was installed before, or to the default action
+void SerialRAMMap::onFault(int signal, siginfo_t* info, void* context) {
+	for(uint8_t i = 0; i < SERIALRAM_MAP_MAX; i++) {
+		if(SerialRAMMap::maps[i] && SerialRAMMap::maps[i]->handleFault(info->si_addr)) {
+			return;
+		}
+	}
+	if(previousHandler.sa_flags & SA_SIGINFO) {
+		previousHandler.sa_sigaction(signal, info, context);
+	}
+	else if(previousHandler.sa_handler != SIG_DFL && previousHandler.sa_handler != SIG_IGN) {
+		previousHandler.sa_handler(signal);
+	}
+	else {
+		//returning replays the access, which now faults with the default action
+		::signal(SIGSEGV, SIG_DFL);
+	}
+}
+
+bool SerialRAMMap::handleFault(void* address) {
+	uint8_t* at = (uint8_t*)address;
+	if(!this->view || at < this->view || at >= this->view + this->mappedSize) {
+		return false;
+	}
+	size_t page = (at - this->view) / this->pageSize;
+	if(mprotect(this->view + page * this->pageSize, this->pageSize, PROT_READ | PROT_WRITE)) {
+		return false;
+	}
+	this->dirty[page] = 1;
+	return true;
+}
+
+uint8_t SerialRAMMap::flushPage(const size_t page) {
+	size_t start = page * this->pageSize;
+	size_t end = start + this->pageSize < this->size ? start + this->pageSize : this->size;
+	size_t block = start;
+	while(block < end) {
+		size_t length = end - block < SERIALRAM_MAP_BLOCK ? end - block : SERIALRAM_MAP_BLOCK;
+		if(!memcmp(this->view + block, this->shadow + block, length)) {
+			block += length;
+			continue;
+		}
+		//extend the run over the following differing blocks so it goes out in one write
+		size_t run = block + length;
+		while(run < end) {
+			size_t next = end - run < SERIALRAM_MAP_BLOCK ? end - run : SERIALRAM_MAP_BLOCK;
+			if(!memcmp(this->view + run, this->shadow + run, next)) {
+				break;
+			}
+			run += next;
+		}
+		uint8_t status = this->transport->write(block, this->view + block, run - block);
+		if(status) {
+			return status;
+		}
+		memcpy(this->shadow + block, this->view + block, run - block);
+		block = run;
+	}
+	return 0;
+}
+
+#endif
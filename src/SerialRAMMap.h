@@ -0,0 +1,107 @@
+/*
+	SerialRAMMap.h
+	Linux userspace only: memory mapped view of an EERAM image, flushing the modified pages through i2c-dev or an image file
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#ifndef _SerialRAMMap_h
+#define _SerialRAMMap_h
+
+#if defined(__linux__) && !defined(ARDUINO)
+
+#include <stdint.h>
+#include <stddef.h>
+#include <signal.h>
+
+//Largest number of bytes moved in a single i2c-dev transaction
+#ifndef SERIALRAM_MAP_TRANSFER
+	#define SERIALRAM_MAP_TRANSFER 256
+#endif
+
+//Granularity at which a dirty page is compared with its last flushed content
+#ifndef SERIALRAM_MAP_BLOCK
+	#define SERIALRAM_MAP_BLOCK 16
+#endif
+
+//Largest number of views mapped at the same time
+#ifndef SERIALRAM_MAP_MAX
+	#define SERIALRAM_MAP_MAX 4
+#endif
+
+//Where the bytes of the chip come from and go to. Status codes follow SerialRAM: 0 success, 4 transfer error, 5 out of bounds.
+class SerialRAMTransport {
+public:
+	virtual ~SerialRAMTransport() {}
+	virtual uint8_t read(const uint16_t address, uint8_t* values, const uint16_t size) = 0;
+	virtual uint8_t write(const uint16_t address, const uint8_t* values, const uint16_t size) = 0;
+};
+
+//Chip on a Linux I2C adapter, e.g. /dev/i2c-1
+class SerialRAMI2CDevTransport : public SerialRAMTransport {
+private:
+	int fd;
+	uint8_t SRAM_REGISTER;
+	uint8_t STORAGE_ARRAY_SIZE;
+
+public:
+	SerialRAMI2CDevTransport();
+	~SerialRAMI2CDevTransport();
+
+	uint8_t begin(const char* device, const uint8_t A0 = 0, const uint8_t A1 = 0, const uint8_t SIZE = 16);
+	void end();
+	uint8_t read(const uint16_t address, uint8_t* values, const uint16_t size);
+	uint8_t write(const uint16_t address, const uint8_t* values, const uint16_t size);
+};
+
+//Chip image stored in a file, for simulation and tests without hardware
+class SerialRAMFileTransport : public SerialRAMTransport {
+private:
+	int fd;
+	uint16_t size;
+
+public:
+	SerialRAMFileTransport();
+	~SerialRAMFileTransport();
+
+	uint8_t begin(const char* path, const uint16_t size);
+	void end();
+	uint8_t read(const uint16_t address, uint8_t* values, const uint16_t size);
+	uint8_t write(const uint16_t address, const uint8_t* values, const uint16_t size);
+};
+
+class SerialRAMMap {
+private:
+	SerialRAMTransport* transport;
+	uint8_t* view;
+	uint8_t* shadow;
+	volatile uint8_t* dirty;
+	size_t pageSize;
+	size_t mappedSize;
+	uint16_t size;
+
+	static SerialRAMMap* maps[SERIALRAM_MAP_MAX];
+	static void onFault(int signal, siginfo_t* info, void* context);
+	static bool installHandler();
+
+	bool handleFault(void* address);
+	uint8_t flushPage(const size_t page);
+
+public:
+	SerialRAMMap();
+	~SerialRAMMap();
+
+	uint8_t open(SerialRAMTransport& transport, const uint16_t size);
+	uint8_t sync();
+	uint8_t close();
+
+	uint8_t* data();
+	uint16_t length();
+	size_t dirtyPages();
+};
+
+#endif
+
+#endif
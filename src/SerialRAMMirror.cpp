@@ -0,0 +1,111 @@
+/*
+	SerialRAMMirror.cpp
+	Host RAM mirror of a SerialRAM region, protected by a sequence lock so interrupt handlers can read it without the bus
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#include <stdint.h>
+#include "SerialRAMMirror.h"
+
+
+///<summary>
+///	Mirror the device range [address, address + size) in "buffer".
+///		Writes are done from the main loop through write(), readers in any context use tryRead().
+///	<param name="ram">initialized SerialRAM chip</param>
+///	<param name="address">16 bit address of the mirrored range</param>
+///	<param name="buffer">host buffer of at least size bytes</param>
+///	<param name="size">size of the range in bytes</param>
+///</summary>
+SerialRAMMirror::SerialRAMMirror(SerialRAM& ram, const uint16_t address, uint8_t* buffer, const uint16_t size) {
+	this->ram = &ram;
+	this->address = address;
+	this->buffer = buffer;
+	this->size = size;
+	this->sequence = 0;
+}
+
+///<summary>
+///	Fill the mirror from the chip, for instance at boot.
+///		<returns>same as SerialRAM::read()</returns>
+///</summary>
+uint8_t SerialRAMMirror::load() {
+	uint8_t chunk[SERIALRAM_CHUNK_SIZE];
+	uint16_t done = 0;
+	//read chunk by chunk so readers are only locked out for one short copy at a time
+	while(done < this->size) {
+		uint8_t n = (this->size - done) > SERIALRAM_CHUNK_SIZE ? SERIALRAM_CHUNK_SIZE : (this->size - done);
+		uint8_t status = this->ram->read(this->address + done, chunk, n);
+		if(status) {
+			return status;
+		}
+		this->update(done, chunk, n);
+		done += n;
+	}
+	return 0;
+}
+
+///<summary>
+///	Write "size" bytes to the chip, then publish them in the mirror. Call it from the main loop only.
+///		Only the part of the range that overlaps the mirror is published, the rest is written to the chip only.
+///		<returns>same as SerialRAM::write(). The mirror is left unchanged if the chip write fails.</returns>
+///</summary>
+uint8_t SerialRAMMirror::write(const uint16_t address, const uint8_t* values, const uint16_t size) {
+	uint8_t status = this->ram->write(address, values, size);
+	if(status) {
+		return status;
+	}
+	//publish the part of the range that overlaps the mirror
+	uint32_t start = address > this->address ? address : this->address;
+	uint32_t end = (uint32_t)address + size;
+	if(end > (uint32_t)this->address + this->size) {
+		end = (uint32_t)this->address + this->size;
+	}
+	if(start < end) {
+		this->update(start - this->address, values + (start - address), end - start);
+	}
+	return 0;
+}
+
+///<summary>
+///	Write a single byte, see write(address, values, size).
+///</summary>
+uint8_t SerialRAMMirror::write(const uint16_t address, const uint8_t value) {
+	return this->write(address, &value, 1);
+}
+
+///<summary>
+///	Copy "size" mirrored bytes starting at the chip address "address" without touching the bus or blocking.
+///		Safe in an interrupt handler. If the handler interrupted write() in the middle of an update the copy
+///		may be torn, in which case false is returned and the caller keeps its previous value or retries later.
+///		Never spin on it from an interrupt handler: the writer cannot finish until the handler returns.
+///		<param name="address">16 bit chip address, inside the mirrored range</param>
+///		<param name="values">destination of the copy</param>
+///		<param name="size">number of bytes</param>
+///		<returns>true if "values" holds a consistent copy</returns>
+///</summary>
+bool SerialRAMMirror::tryRead(const uint16_t address, void* values, const uint16_t size) {
+	if(!this->contains(address, size)) {
+		return false;
+	}
+	uint8_t before = __atomic_load_n(&this->sequence, __ATOMIC_ACQUIRE);
+	if(before & 1) {
+		return false;
+	}
+	memcpy(values, this->buffer + (address - this->address), size);
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	return __atomic_load_n(&this->sequence, __ATOMIC_RELAXED) == before;
+}
+
+bool SerialRAMMirror::contains(const uint16_t address, const uint16_t size) {
+	return address >= this->address && size <= this->size && address - this->address <= this->size - size;
+}
+
+void SerialRAMMirror::update(const uint16_t offset, const uint8_t* values, const uint16_t size) {
+	__atomic_store_n(&this->sequence, (uint8_t)(this->sequence + 1), __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	memcpy(this->buffer + offset, values, size);
+	__atomic_store_n(&this->sequence, (uint8_t)(this->sequence + 1), __ATOMIC_RELEASE);
+}
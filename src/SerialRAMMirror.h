@@ -0,0 +1,44 @@
+/*
+	SerialRAMMirror.h
+	Host RAM mirror of a SerialRAM region, protected by a sequence lock so interrupt handlers can read it without the bus
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#ifndef _SerialRAMMirror_h
+#define _SerialRAMMirror_h
+
+#include "SerialRAM.h"
+
+class SerialRAMMirror {
+private:
+	SerialRAM* ram;
+	uint16_t address;
+	uint8_t* buffer;
+	uint16_t size;
+	//odd while the main loop updates the buffer
+	volatile uint8_t sequence;
+
+	bool contains(const uint16_t address, const uint16_t size);
+	void update(const uint16_t offset, const uint8_t* values, const uint16_t size);
+
+public:
+	SerialRAMMirror(SerialRAM& ram, const uint16_t address, uint8_t* buffer, const uint16_t size);
+
+	uint8_t load();
+	uint8_t write(const uint16_t address, const uint8_t* values, const uint16_t size);
+	uint8_t write(const uint16_t address, const uint8_t value);
+	bool tryRead(const uint16_t address, void* values, const uint16_t size);
+
+	///<summary>
+	///	Lock free read of a multi-byte value, see tryRead().
+	///</summary>
+	template<typename T>
+	bool tryGet(const uint16_t address, T* value) {
+		return this->tryRead(address, value, sizeof(T));
+	}
+};
+
+#endif
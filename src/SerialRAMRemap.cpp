@@ -0,0 +1,273 @@
+/*
+	SerialRAMRemap.cpp
+	Logical to physical block translation over a SerialRAM chip, so data can be relocated by updating one table entry
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#include <stdint.h>
+#include "SerialRAMRemap.h"
+#include "SerialRAMCrc.h"
+
+
+///<summary>
+///	Translate "logicalBlocks" blocks of SERIALRAM_REMAP_BLOCK bytes onto "physicalBlocks" blocks starting at "dataAddress".
+///		The table lives in host RAM and every change is persisted at "tableAddress" in the older of two CRC checked
+///		copies, so a reset during an update leaves the previous table intact. Having more physical than logical blocks
+///		leaves spare blocks to relocate into.
+///	<param name="ram">initialized SerialRAM chip</param>
+///	<param name="tableAddress">16 bit address of SERIALRAM_REMAP_TABLE_SIZE(logicalBlocks) bytes holding the table</param>
+///	<param name="dataAddress">16 bit address of the first physical block</param>
+///	<param name="logicalBlocks">number of blocks seen through read() and write()</param>
+///	<param name="physicalBlocks">number of blocks on the chip, at least logicalBlocks</param>
+///</summary>
+SerialRAMRemap::SerialRAMRemap(SerialRAM& ram, const uint16_t tableAddress, const uint16_t dataAddress, const uint8_t logicalBlocks, const uint8_t physicalBlocks) {
+	this->ram = &ram;
+	this->tableAddress = tableAddress;
+	this->dataAddress = dataAddress;
+	this->physicalBlocks = physicalBlocks > SERIALRAM_REMAP_MAX_BLOCKS ? SERIALRAM_REMAP_MAX_BLOCKS : physicalBlocks;
+	this->logicalBlocks = logicalBlocks > this->physicalBlocks ? this->physicalBlocks : logicalBlocks;
+	this->sequence = 0;
+	for(uint8_t i = 0; i < this->logicalBlocks; i++) {
+		this->table[i] = i;
+	}
+}
+
+///<summary>
+///	Load the newest valid copy of the table. When neither copy is valid, e.g. on a blank chip, the table is reset
+///	to the identity mapping.
+///		<returns>0:success, 1-4 : same as SerialRAM::read(), 6 : no valid table was stored, the identity mapping was written</returns>
+///</summary>
+uint8_t SerialRAMRemap::begin() {
+	uint8_t entries[2][SERIALRAM_REMAP_MAX_BLOCKS];
+	uint8_t sequences[2];
+	bool valid[2];
+	for(uint8_t copy = 0; copy < 2; copy++) {
+		uint8_t status = this->loadCopy(copy, entries[copy], &sequences[copy]);
+		if(status && status != 6) {
+			return status;
+		}
+		valid[copy] = !status;
+	}
+	if(!valid[0] && !valid[1]) {
+		uint8_t status = this->reset();
+		return status ? status : 6;
+	}
+	//sequences wrap around, the newer copy is the one exactly one step ahead
+	uint8_t newest = valid[0] && (!valid[1] || (uint8_t)(sequences[0] - sequences[1]) == 1) ? 0 : 1;
+	memcpy(this->table, entries[newest], this->logicalBlocks);
+	this->sequence = sequences[newest];
+	return 0;
+}
+
+///<summary>
+///	Map every logical block onto the physical block with the same number and persist it. The data is not moved.
+///		<returns>same as SerialRAM::write()</returns>
+///</summary>
+uint8_t SerialRAMRemap::reset() {
+	for(uint8_t i = 0; i < this->logicalBlocks; i++) {
+		this->table[i] = i;
+	}
+	return this->persist();
+}
+
+///<summary>
+///	Write the table to the older copy on the chip, which becomes the newest once its CRC is written.
+///		<returns>same as SerialRAM::write()</returns>
+///</summary>
+uint8_t SerialRAMRemap::persist() {
+	uint8_t sequence = this->sequence + 1;
+	uint16_t crc = serialRAMCrc16(&sequence, 1);
+	crc = serialRAMCrc16(this->table, this->logicalBlocks, crc);
+	uint16_t at = this->tableAddress + (sequence & 1) * SERIALRAM_REMAP_COPY_SIZE(this->logicalBlocks);
+	uint8_t trailer[2] = { (uint8_t)(crc & 0xff), (uint8_t)(crc >> 8) };
+	uint8_t status = this->ram->write(at, &sequence, 1);
+	if(!status) {
+		status = this->ram->write(at + 1, this->table, this->logicalBlocks);
+	}
+	if(!status) {
+		status = this->ram->write(at + 1 + this->logicalBlocks, trailer, 2);
+	}
+	if(status) {
+		return status;
+	}
+	this->sequence = sequence;
+	return 0;
+}
+
+///<summary>
+///	Read "size" bytes at the logical address "address", split at block boundaries.
+///		<returns>0:success, 1-4 : same as SerialRAM::read(), 5 : range outside the logical blocks</returns>
+///</summary>
+uint8_t SerialRAMRemap::read(const uint16_t address, uint8_t* values, const uint16_t size) {
+	return this->transfer(address, values, size, false);
+}
+
+///<summary>
+///	Write "size" bytes at the logical address "address", split at block boundaries.
+///		<returns>0:success, 1-4 : same as SerialRAM::write(), 5 : range outside the logical blocks</returns>
+///</summary>
+uint8_t SerialRAMRemap::write(const uint16_t address, const uint8_t* values, const uint16_t size) {
+	return this->transfer(address, (uint8_t*)values, size, true);
+}
+
+///<summary>
+///	Physical block holding the logical block "logical", SERIALRAM_REMAP_NONE if out of range.
+///</summary>
+uint8_t SerialRAMRemap::physical(const uint8_t logical) {
+	return logical < this->logicalBlocks ? this->table[logical] : SERIALRAM_REMAP_NONE;
+}
+
+///<summary>
+///	Chip address of the logical address "address", SERIALRAM_NOT_FOUND if out of range.
+///</summary>
+uint16_t SerialRAMRemap::physicalAddress(const uint16_t address) {
+	uint16_t logical = address / SERIALRAM_REMAP_BLOCK;
+	if(logical >= this->logicalBlocks) {
+		return SERIALRAM_NOT_FOUND;
+	}
+	return this->dataAddress + this->table[logical] * SERIALRAM_REMAP_BLOCK + address % SERIALRAM_REMAP_BLOCK;
+}
+
+///<summary>
+///	First physical block no logical block is mapped onto, SERIALRAM_REMAP_NONE if every block is used.
+///</summary>
+uint8_t SerialRAMRemap::freeBlock() {
+	for(uint8_t block = 0; block < this->physicalBlocks; block++) {
+		bool used = false;
+		for(uint8_t i = 0; i < this->logicalBlocks && !used; i++) {
+			used = this->table[i] == block;
+		}
+		if(!used) {
+			return block;
+		}
+	}
+	return SERIALRAM_REMAP_NONE;
+}
+
+///<summary>
+///	Move the logical block "logical" to the free physical block "physical": the data is copied on the chip,
+///	then the table entry is updated and persisted. Until the table is persisted the old block stays valid.
+///		<returns>0:success, 1-4 : same as SerialRAM::write(), 5 : block out of range, 6 : physical block in use</returns>
+///</summary>
+uint8_t SerialRAMRemap::relocate(const uint8_t logical, const uint8_t physical) {
+	if(logical >= this->logicalBlocks || physical >= this->physicalBlocks) {
+		return 5;
+	}
+	if(this->table[logical] == physical) {
+		return 0;
+	}
+	for(uint8_t i = 0; i < this->logicalBlocks; i++) {
+		if(this->table[i] == physical) {
+			return 6;
+		}
+	}
+	uint8_t status = this->ram->move(this->dataAddress + physical * SERIALRAM_REMAP_BLOCK, this->dataAddress + this->table[logical] * SERIALRAM_REMAP_BLOCK, SERIALRAM_REMAP_BLOCK);
+	if(status) {
+		return status;
+	}
+	return this->map(logical, physical);
+}
+
+///<summary>
+///	Point the logical block "logical" at the free physical block "physical" without copying anything,
+///	for instance to publish a block prepared in a spare physical block, and persist the table.
+///		<returns>0:success, 1-4 : same as SerialRAM::write(), 5 : block out of range, 6 : physical block in use</returns>
+///</summary>
+uint8_t SerialRAMRemap::map(const uint8_t logical, const uint8_t physical) {
+	if(logical >= this->logicalBlocks || physical >= this->physicalBlocks) {
+		return 5;
+	}
+	for(uint8_t i = 0; i < this->logicalBlocks; i++) {
+		if(i != logical && this->table[i] == physical) {
+			return 6;
+		}
+	}
+	uint8_t previous = this->table[logical];
+	this->table[logical] = physical;
+	uint8_t status = this->persist();
+	if(status) {
+		this->table[logical] = previous;
+	}
+	return status;
+}
+
+///<summary>
+///	Exchange the physical blocks of two logical blocks in a single table update, e.g. to flip A/B banks.
+///		<returns>0:success, 1-4 : same as SerialRAM::write(), 5 : block out of range</returns>
+///</summary>
+uint8_t SerialRAMRemap::swap(const uint8_t first, const uint8_t second) {
+	if(first >= this->logicalBlocks || second >= this->logicalBlocks) {
+		return 5;
+	}
+	uint8_t block = this->table[first];
+	this->table[first] = this->table[second];
+	this->table[second] = block;
+	uint8_t status = this->persist();
+	if(status) {
+		this->table[second] = this->table[first];
+		this->table[first] = block;
+	}
+	return status;
+}
+
+//Read one stored copy and check it, 6 when the CRC or the entries are wrong
+uint8_t SerialRAMRemap::loadCopy(const uint8_t copy, uint8_t* entries, uint8_t* sequence) {
+	uint16_t at = this->tableAddress + copy * SERIALRAM_REMAP_COPY_SIZE(this->logicalBlocks);
+	uint8_t trailer[2];
+	uint8_t status = this->ram->read(at, sequence, 1);
+	if(!status) {
+		status = this->ram->read(at + 1, entries, this->logicalBlocks);
+	}
+	if(!status) {
+		status = this->ram->read(at + 1 + this->logicalBlocks, trailer, 2);
+	}
+	if(status) {
+		return status;
+	}
+	uint16_t crc = serialRAMCrc16(sequence, 1);
+	crc = serialRAMCrc16(entries, this->logicalBlocks, crc);
+	if((trailer[0] | (trailer[1] << 8)) != crc || (*sequence & 1) != copy || !this->isValid(entries)) {
+		return 6;
+	}
+	return 0;
+}
+
+//Every entry is a physical block and no two logical blocks share one
+bool SerialRAMRemap::isValid(const uint8_t* entries) {
+	for(uint8_t i = 0; i < this->logicalBlocks; i++) {
+		if(entries[i] >= this->physicalBlocks) {
+			return false;
+		}
+		for(uint8_t j = 0; j < i; j++) {
+			if(entries[j] == entries[i]) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+uint8_t SerialRAMRemap::transfer(const uint16_t address, uint8_t* values, const uint16_t size, const bool write) {
+	uint16_t total = this->logicalBlocks * SERIALRAM_REMAP_BLOCK;
+	if(size > total || address > total - size) {
+		return 5;
+	}
+	uint16_t done = 0;
+	while(done < size) {
+		uint16_t at = address + done;
+		uint16_t length = SERIALRAM_REMAP_BLOCK - at % SERIALRAM_REMAP_BLOCK;
+		if(length > size - done) {
+			length = size - done;
+		}
+		uint16_t physical = this->physicalAddress(at);
+		uint8_t status = write ? this->ram->write(physical, values + done, length) : this->ram->read(physical, values + done, length);
+		if(status) {
+			return status;
+		}
+		done += length;
+	}
+	return 0;
+}
@@ -0,0 +1,71 @@
+/*
+	SerialRAMRemap.h
+	Logical to physical block translation over a SerialRAM chip, so data can be relocated by updating one table entry
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#ifndef _SerialRAMRemap_h
+#define _SerialRAMRemap_h
+
+#include "SerialRAM.h"
+
+//Size in bytes of a remapped block
+#ifndef SERIALRAM_REMAP_BLOCK
+	#define SERIALRAM_REMAP_BLOCK 32
+#endif
+
+//Largest number of logical or physical blocks, enough for a whole 47x16 chip. Costs one byte of host RAM per logical block.
+#ifndef SERIALRAM_REMAP_MAX_BLOCKS
+	#define SERIALRAM_REMAP_MAX_BLOCKS (2048 / SERIALRAM_REMAP_BLOCK)
+#endif
+
+//Returned by physical() and freeBlock() when there is no block
+#define SERIALRAM_REMAP_NONE 0xff
+
+//One copy of the table on the chip: sequence (1), entries (one per logical block), crc16 (2)
+#define SERIALRAM_REMAP_COPY_SIZE(logicalBlocks) ((logicalBlocks) + 3)
+
+//Room to reserve at the table address: the table is kept twice and updates alternate between both copies
+#define SERIALRAM_REMAP_TABLE_SIZE(logicalBlocks) (2 * SERIALRAM_REMAP_COPY_SIZE(logicalBlocks))
+
+#if SERIALRAM_REMAP_MAX_BLOCKS > 255
+	#error "SerialRAMRemap stores physical block numbers on one byte, SERIALRAM_REMAP_MAX_BLOCKS must be 255 or less"
+#endif
+
+class SerialRAMRemap {
+private:
+	SerialRAM* ram;
+	uint16_t tableAddress;
+	uint16_t dataAddress;
+	uint8_t logicalBlocks;
+	uint8_t physicalBlocks;
+	uint8_t sequence;
+	uint8_t table[SERIALRAM_REMAP_MAX_BLOCKS];
+
+	uint8_t loadCopy(const uint8_t copy, uint8_t* entries, uint8_t* sequence);
+	bool isValid(const uint8_t* entries);
+	uint8_t transfer(const uint16_t address, uint8_t* values, const uint16_t size, const bool write);
+
+public:
+	SerialRAMRemap(SerialRAM& ram, const uint16_t tableAddress, const uint16_t dataAddress, const uint8_t logicalBlocks, const uint8_t physicalBlocks);
+
+	uint8_t begin();
+	uint8_t reset();
+	uint8_t persist();
+
+	uint8_t read(const uint16_t address, uint8_t* values, const uint16_t size);
+	uint8_t write(const uint16_t address, const uint8_t* values, const uint16_t size);
+
+	uint8_t physical(const uint8_t logical);
+	uint16_t physicalAddress(const uint16_t address);
+	uint8_t freeBlock();
+
+	uint8_t relocate(const uint8_t logical, const uint8_t physical);
+	uint8_t map(const uint8_t logical, const uint8_t physical);
+	uint8_t swap(const uint8_t first, const uint8_t second);
+};
+
+#endif
@@ -0,0 +1,193 @@
+/*
+	SerialRAMSchema.cpp
+	Versioned layout header and in place migration engine for data persisted in a SerialRAM chip
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#include <stdint.h>
+#include "SerialRAMSchema.h"
+#include "SerialRAMCrc.h"
+
+
+///<summary>
+///	Create a schema whose header lives at "base". The layout itself starts right after the header.
+///	<param name="ram">initialized SerialRAM chip holding the layout</param>
+///	<param name="base">16 bit address of the header</param>
+///</summary>
+SerialRAMSchema::SerialRAMSchema(SerialRAM& ram, const uint16_t base) {
+	this->ram = &ram;
+	this->base = base;
+	this->version = 0;
+	this->storedVersion = 0xffff;
+	this->sequence = 0;
+}
+
+///<summary>
+///	Read the header and bring the stored layout up to "version" by running the matching migrations in order.
+///		Each migration is a list of chunked device side moves and fills, so no host copy of the layout is ever needed.
+///		Progress is saved after every piece of every operation, so a step interrupted by a reset resumes where it stopped,
+///		see apply().
+///		A chip without a valid header is stamped with "version" and left untouched otherwise.
+///		<param name="version">layout version the firmware expects</param>
+///		<param name="migrations">migration steps, one per version increment, in any order</param>
+///		<param name="count">number of entries in migrations</param>
+///		<returns>0:success, 1-5 : same as SerialRAM::write(), 6 : stored version is newer or no migration path exists</returns>
+///</summary>
+uint8_t SerialRAMSchema::begin(const uint16_t version, const SerialRAMMigration* migrations, const uint8_t count) {
+	uint8_t headers[2][SERIALRAM_SCHEMA_HEADER_COPY];
+	bool valid[2];
+	for(uint8_t copy = 0; copy < 2; copy++) {
+		uint8_t status = this->readHeader(copy, headers[copy]);
+		if(status && status != 6) {
+			return status;
+		}
+		valid[copy] = !status;
+	}
+	this->version = version;
+
+	if(!valid[0] && !valid[1]) {
+		this->storedVersion = 0xffff;
+		return this->writeHeader(version, 0, 0);
+	}
+	//sequences wrap around, the newer copy is the one exactly one step ahead
+	uint8_t* header = headers[valid[0] && (!valid[1] || (uint8_t)(headers[0][2] - headers[1][2]) == 1) ? 0 : 1];
+	this->sequence = header[2];
+	uint16_t current = header[3] | (header[4] << 8);
+	uint8_t pending = header[5];
+	uint16_t done = header[6] | (header[7] << 8);
+	this->storedVersion = current;
+	if(current > version) {
+		return 6;
+	}
+
+	while(current < version) {
+		const SerialRAMMigration* step = 0;
+		for(uint8_t i = 0; i < count; i++) {
+			if(migrations[i].fromVersion == current) {
+				step = &migrations[i];
+				break;
+			}
+		}
+		if(!step) {
+			return 6;
+		}
+		for(uint8_t i = pending; i < step->count; i++) {
+			uint8_t status = this->apply(step->ops[i], current, i, i == pending ? done : 0);
+			if(status) {
+				return status;
+			}
+		}
+		current++;
+		pending = 0;
+		done = 0;
+		uint8_t status = this->writeHeader(current, 0, 0);
+		if(status) {
+			return status;
+		}
+	}
+	return 0;
+}
+
+///<summary>
+///	Layout version given to begin().
+///</summary>
+uint16_t SerialRAMSchema::getVersion() {
+	return this->version;
+}
+
+///<summary>
+///	Layout version found on the chip by begin(), before any migration.
+///		<returns>stored version, or 0xFFFF if the chip had no valid header</returns>
+///</summary>
+uint16_t SerialRAMSchema::getStoredVersion() {
+	return this->storedVersion;
+}
+
+///<summary>
+///	Address of the first byte of the layout, right after the header.
+///</summary>
+uint16_t SerialRAMSchema::dataAddress() {
+	return this->base + SERIALRAM_SCHEMA_HEADER_SIZE;
+}
+
+//Read one header copy, 6 when its magic, CRC or sequence does not match
+uint8_t SerialRAMSchema::readHeader(const uint8_t copy, uint8_t* header) {
+	uint8_t status = this->ram->read(this->base + copy * SERIALRAM_SCHEMA_HEADER_COPY, header, SERIALRAM_SCHEMA_HEADER_COPY);
+	if(status) {
+		return status;
+	}
+	uint16_t magic = header[0] | (header[1] << 8);
+	uint16_t crc = serialRAMCrc16(header, SERIALRAM_SCHEMA_HEADER_COPY - 2);
+	if(magic != SERIALRAM_SCHEMA_MAGIC || (header[2] & 1) != copy
+		|| (header[SERIALRAM_SCHEMA_HEADER_COPY - 2] | (header[SERIALRAM_SCHEMA_HEADER_COPY - 1] << 8)) != crc) {
+		return 6;
+	}
+	return 0;
+}
+
+//Write the header to the older copy, the CRC makes it the newest only once it is complete
+uint8_t SerialRAMSchema::writeHeader(const uint16_t version, const uint8_t pending, const uint16_t done) {
+	uint8_t sequence = this->sequence + 1;
+	uint8_t header[SERIALRAM_SCHEMA_HEADER_COPY];
+	header[0] = SERIALRAM_SCHEMA_MAGIC & 0xff;
+	header[1] = SERIALRAM_SCHEMA_MAGIC >> 8;
+	header[2] = sequence;
+	header[3] = version & 0xff;
+	header[4] = version >> 8;
+	header[5] = pending;
+	header[6] = done & 0xff;
+	header[7] = done >> 8;
+	uint16_t crc = serialRAMCrc16(header, SERIALRAM_SCHEMA_HEADER_COPY - 2);
+	header[8] = crc & 0xff;
+	header[9] = crc >> 8;
+	uint8_t status = this->ram->write(this->base + (sequence & 1) * SERIALRAM_SCHEMA_HEADER_COPY, header, SERIALRAM_SCHEMA_HEADER_COPY);
+	if(!status) {
+		this->sequence = sequence;
+	}
+	return status;
+}
+
+//Run operation "index" of the step from "version", "done" bytes of it being already complete, one piece at a time.
+//The progress is saved after each piece. A MOVE between overlapping ranges goes in the direction memmove would use,
+//with pieces no larger than the distance between both ranges: a piece never overwrites its own source, nor the source
+//of a piece not done yet, so redoing the last piece after a reset gives the same result.
+uint8_t SerialRAMSchema::apply(const SerialRAMMigrationOp& op, const uint16_t version, const uint8_t index, uint16_t done) {
+	uint8_t buffer[SERIALRAM_CHUNK_SIZE];
+	uint16_t data = this->dataAddress();
+	if(op.type != SERIALRAM_OP_MOVE && op.type != SERIALRAM_OP_FILL) {
+		return 6;
+	}
+	bool move = op.type == SERIALRAM_OP_MOVE;
+	if(move && op.destination == op.source) {
+		done = op.size;
+	}
+	uint16_t distance = op.destination > op.source ? op.destination - op.source : op.source - op.destination;
+	bool backwards = move && op.destination > op.source && op.destination < op.source + op.size;
+	uint16_t limit = SERIALRAM_CHUNK_SIZE;
+	if(move && distance < op.size && distance < limit) {
+		limit = distance;
+	}
+	if(!move) {
+		memset(buffer, (uint8_t)op.source, sizeof(buffer));
+	}
+	while(done < op.size) {
+		uint16_t n = op.size - done < limit ? op.size - done : limit;
+		uint16_t offset = backwards ? op.size - done - n : done;
+		uint8_t status = move ? this->ram->read(data + op.source + offset, buffer, n) : 0;
+		if(!status) {
+			status = this->ram->write(data + op.destination + offset, buffer, n);
+		}
+		if(status) {
+			return status;
+		}
+		done += n;
+		status = done < op.size ? this->writeHeader(version, index, done) : this->writeHeader(version, index + 1, 0);
+		if(status) {
+			return status;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,64 @@
+/*
+	SerialRAMSchema.h
+	Versioned layout header and in place migration engine for data persisted in a SerialRAM chip
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#ifndef _SerialRAMSchema_h
+#define _SerialRAMSchema_h
+
+#include "SerialRAM.h"
+
+//One copy of the header: magic (2), sequence (1), version (2), next pending operation (1), bytes of it done (2), crc16 (2)
+#define SERIALRAM_SCHEMA_HEADER_COPY 10
+
+//Size in bytes of the header written in front of the layout. It is kept twice and updates alternate between both
+//copies, so a reset in the middle of a header write leaves the previous one.
+#define SERIALRAM_SCHEMA_HEADER_SIZE (2 * SERIALRAM_SCHEMA_HEADER_COPY)
+#define SERIALRAM_SCHEMA_MAGIC 0x5253
+
+//Migration operation types
+#define SERIALRAM_OP_MOVE 0
+#define SERIALRAM_OP_FILL 1
+
+//One device side operation of a migration step. Addresses are relative to the first byte after the header.
+//For SERIALRAM_OP_FILL, "source" holds the fill value.
+typedef struct {
+	uint8_t type;
+	uint16_t destination;
+	uint16_t source;
+	uint16_t size;
+} SerialRAMMigrationOp;
+
+//Operations transforming the layout "fromVersion" into the layout "fromVersion + 1"
+typedef struct {
+	uint16_t fromVersion;
+	const SerialRAMMigrationOp* ops;
+	uint8_t count;
+} SerialRAMMigration;
+
+class SerialRAMSchema {
+private:
+	SerialRAM* ram;
+	uint16_t base;
+	uint16_t version;
+	uint16_t storedVersion;
+	uint8_t sequence;
+
+	uint8_t readHeader(const uint8_t copy, uint8_t* header);
+	uint8_t writeHeader(const uint16_t version, const uint8_t pending, const uint16_t done);
+	uint8_t apply(const SerialRAMMigrationOp& op, const uint16_t version, const uint8_t index, uint16_t done);
+
+public:
+	SerialRAMSchema(SerialRAM& ram, const uint16_t base = 0);
+
+	uint8_t begin(const uint16_t version, const SerialRAMMigration* migrations = 0, const uint8_t count = 0);
+	uint16_t getVersion();
+	uint16_t getStoredVersion();
+	uint16_t dataAddress();
+};
+
+#endif
@@ -0,0 +1,168 @@
+/*
+	SerialRAMSnapshot.cpp
+	Full and incremental snapshots of a SerialRAM array into a second chip or a reserved region
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#include <stdint.h>
+#include "SerialRAMSnapshot.h"
+
+
+///<summary>
+///	Protect the range [address, address + size) of "source" with a copy kept at "backup" on "target".
+///		"target" may be the same chip as "source" as long as both ranges do not overlap.
+///	<param name="source">initialized SerialRAM chip holding the live data</param>
+///	<param name="address">16 bit address of the live data</param>
+///	<param name="size">size of the live data in bytes, up to 2048</param>
+///	<param name="target">initialized SerialRAM chip holding the snapshot</param>
+///	<param name="backup">16 bit address of the snapshot on target</param>
+///</summary>
+SerialRAMSnapshot::SerialRAMSnapshot(SerialRAM& source, const uint16_t address, const uint16_t size, SerialRAM& target, const uint16_t backup) {
+	this->source = &source;
+	this->target = &target;
+	this->address = address;
+	this->size = size > SERIALRAM_SNAPSHOT_MAX_BLOCKS * SERIALRAM_SNAPSHOT_BLOCK ? SERIALRAM_SNAPSHOT_MAX_BLOCKS * SERIALRAM_SNAPSHOT_BLOCK : size;
+	this->backup = backup;
+	this->invalidate();
+}
+
+///<summary>
+///	Write a byte to the live data and remember its block as changed since the last snapshot.
+///		<returns>same as SerialRAM::write()</returns>
+///</summary>
+uint8_t SerialRAMSnapshot::write(const uint16_t address, const uint8_t value) {
+	this->markDirty(address, 1);
+	return this->source->write(address, value);
+}
+
+///<summary>
+///	Write an array of bytes to the live data and remember its blocks as changed since the last snapshot.
+///		<returns>same as SerialRAM::write()</returns>
+///</summary>
+uint8_t SerialRAMSnapshot::write(const uint16_t address, const uint8_t* values, const uint16_t size) {
+	this->markDirty(address, size);
+	return this->source->write(address, values, size);
+}
+
+///<summary>
+///	Record that the live range [address, address + size) was changed without going through write().
+///		Parts outside the protected range are ignored.
+///</summary>
+void SerialRAMSnapshot::markDirty(const uint16_t address, const uint16_t size) {
+	if(!size || address >= this->address + this->size || address + size <= this->address) {
+		return;
+	}
+	uint16_t start = address < this->address ? 0 : address - this->address;
+	uint16_t end = address + size - this->address;
+	if(end > this->size) {
+		end = this->size;
+	}
+	for(uint16_t b = start / SERIALRAM_SNAPSHOT_BLOCK; b <= (end - 1) / SERIALRAM_SNAPSHOT_BLOCK; b++) {
+		this->dirty[b >> 3] |= 1 << (b & 7);
+	}
+}
+
+///<summary>
+///	Whether the live data changed since the last snapshot() or rollback().
+///</summary>
+bool SerialRAMSnapshot::isDirty() {
+	for(uint8_t i = 0; i < sizeof(this->dirty); i++) {
+		if(this->dirty[i]) {
+			return true;
+		}
+	}
+	return false;
+}
+
+///<summary>
+///	Copy the live data into the snapshot. The first call copies the whole range,
+///	later calls only copy the blocks changed since the previous snapshot, merged into as few transfers as possible.
+///		<returns>same as SerialRAM::write()</returns>
+///</summary>
+uint8_t SerialRAMSnapshot::snapshot() {
+	if(!this->valid) {
+		uint8_t status = copy(*this->source, this->address, *this->target, this->backup, this->size);
+		if(status) {
+			return status;
+		}
+		memset(this->dirty, 0, sizeof(this->dirty));
+		this->valid = true;
+		return 0;
+	}
+	return this->copyDirty(false);
+}
+
+///<summary>
+///	Restore the live data from the snapshot. Only the blocks changed since the snapshot are copied back.
+///		<returns>0:success, 1-5 : same as SerialRAM::write(), 6 : no snapshot was taken</returns>
+///</summary>
+uint8_t SerialRAMSnapshot::rollback() {
+	if(!this->valid) {
+		return 6;
+	}
+	return this->copyDirty(true);
+}
+
+///<summary>
+///	Forget the snapshot, the next snapshot() will be a full one.
+///</summary>
+void SerialRAMSnapshot::invalidate() {
+	this->valid = false;
+	memset(this->dirty, 0, sizeof(this->dirty));
+}
+
+///<summary>
+///	Copy "size" bytes from one chip to another, one SERIALRAM_CHUNK_SIZE transfer at a time.
+///		When both are the same chip the copy is a SerialRAM::move().
+///		<returns>same as SerialRAM::write()</returns>
+///</summary>
+uint8_t SerialRAMSnapshot::copy(SerialRAM& from, const uint16_t fromAddress, SerialRAM& to, const uint16_t toAddress, const uint16_t size) {
+	if(&from == &to) {
+		return from.move(toAddress, fromAddress, size);
+	}
+	uint8_t buffer[SERIALRAM_CHUNK_SIZE];
+	uint16_t done = 0;
+	while(done < size) {
+		uint8_t n = (size - done) > SERIALRAM_CHUNK_SIZE ? SERIALRAM_CHUNK_SIZE : (size - done);
+		uint8_t status = from.read(fromAddress + done, buffer, n);
+		if(!status) {
+			status = to.write(toAddress + done, buffer, n);
+		}
+		if(status) {
+			return status;
+		}
+		done += n;
+	}
+	return 0;
+}
+
+uint8_t SerialRAMSnapshot::copyDirty(const bool restore) {
+	uint16_t blocks = (this->size + SERIALRAM_SNAPSHOT_BLOCK - 1) / SERIALRAM_SNAPSHOT_BLOCK;
+	uint16_t b = 0;
+	while(b < blocks) {
+		if(!(this->dirty[b >> 3] & (1 << (b & 7)))) {
+			b++;
+			continue;
+		}
+		//merge a run of dirty blocks into one transfer
+		uint16_t first = b;
+		while(b < blocks && (this->dirty[b >> 3] & (1 << (b & 7)))) {
+			b++;
+		}
+		uint16_t offset = first * SERIALRAM_SNAPSHOT_BLOCK;
+		uint16_t length = b * SERIALRAM_SNAPSHOT_BLOCK > this->size ? this->size - offset : (b - first) * SERIALRAM_SNAPSHOT_BLOCK;
+		uint8_t status = restore
+			? copy(*this->target, this->backup + offset, *this->source, this->address + offset, length)
+			: copy(*this->source, this->address + offset, *this->target, this->backup + offset, length);
+		if(status) {
+			return status;
+		}
+		for(uint16_t i = first; i < b; i++) {
+			this->dirty[i >> 3] &= ~(1 << (i & 7));
+		}
+	}
+	return 0;
+}
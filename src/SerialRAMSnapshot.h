@@ -0,0 +1,49 @@
+/*
+	SerialRAMSnapshot.h
+	Full and incremental snapshots of a SerialRAM array into a second chip or a reserved region
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#ifndef _SerialRAMSnapshot_h
+#define _SerialRAMSnapshot_h
+
+#include "SerialRAM.h"
+
+//Granularity of dirty tracking in bytes. 2 KB / 32 = 64 blocks, tracked in an 8 byte bitmap.
+#ifndef SERIALRAM_SNAPSHOT_BLOCK
+	#define SERIALRAM_SNAPSHOT_BLOCK 32
+#endif
+
+#define SERIALRAM_SNAPSHOT_MAX_BLOCKS (2048 / SERIALRAM_SNAPSHOT_BLOCK)
+
+class SerialRAMSnapshot {
+private:
+	SerialRAM* source;
+	SerialRAM* target;
+	uint16_t address;
+	uint16_t size;
+	uint16_t backup;
+	bool valid;
+	uint8_t dirty[(SERIALRAM_SNAPSHOT_MAX_BLOCKS + 7) / 8];
+
+	uint8_t copyDirty(const bool restore);
+
+public:
+	SerialRAMSnapshot(SerialRAM& source, const uint16_t address, const uint16_t size, SerialRAM& target, const uint16_t backup);
+
+	uint8_t write(const uint16_t address, const uint8_t value);
+	uint8_t write(const uint16_t address, const uint8_t* values, const uint16_t size);
+	void markDirty(const uint16_t address, const uint16_t size);
+	bool isDirty();
+
+	uint8_t snapshot();
+	uint8_t rollback();
+	void invalidate();
+
+	static uint8_t copy(SerialRAM& from, const uint16_t fromAddress, SerialRAM& to, const uint16_t toAddress, const uint16_t size);
+};
+
+#endif
@@ -0,0 +1,155 @@
+/*
+	SerialRAMSync.cpp
+	Differential copy between two SerialRAM chips, or from a host image to a chip, transferring only the blocks that differ
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#include <stdint.h>
+#include "SerialRAMSync.h"
+#include "SerialRAMCrc.h"
+
+
+///<summary>
+///	CRC-16 of each SERIALRAM_SYNC_BLOCK sized block of [address, address + size), computed by streaming chunked reads.
+///		Exchange them with a remote board to find out which blocks it needs without sending the data itself,
+///		or keep them on the host for the sync() overload that works from a stored hash list.
+///	<param name="hashes">SERIALRAM_SYNC_BLOCKS(size) hashes</param>
+///		<returns>same as SerialRAM::read()</returns>
+///</summary>
+uint8_t SerialRAMSync::hash(SerialRAM& ram, const uint16_t address, const uint16_t size, uint16_t* hashes) {
+	for(uint16_t offset = 0; offset < size; offset += SERIALRAM_SYNC_BLOCK) {
+		uint16_t length = size - offset < SERIALRAM_SYNC_BLOCK ? size - offset : SERIALRAM_SYNC_BLOCK;
+		uint8_t status = hashBlock(ram, address + offset, length, &hashes[offset / SERIALRAM_SYNC_BLOCK]);
+		if(status) {
+			return status;
+		}
+	}
+	return 0;
+}
+
+///<summary>
+///	Make [address, address + size) of "to" identical to the same range of "from".
+///		Each block is read from "from", the matching block of "to" is read a chunk at a time and compared with it,
+///		and the block is only written when a byte differs. Syncing nearly identical chips costs the reads plus a few
+///		block writes, and a chip already in sync is never written. The comparison is exact, no hash is involved.
+///	<param name="copied">when not null, receives the number of blocks written</param>
+///		<returns>same as SerialRAM::write()</returns>
+///</summary>
+uint8_t SerialRAMSync::sync(SerialRAM& from, SerialRAM& to, const uint16_t address, const uint16_t size, uint16_t* copied) {
+	uint8_t block[SERIALRAM_SYNC_BLOCK];
+	uint16_t count = 0;
+	for(uint16_t offset = 0; offset < size; offset += SERIALRAM_SYNC_BLOCK) {
+		uint16_t length = size - offset < SERIALRAM_SYNC_BLOCK ? size - offset : SERIALRAM_SYNC_BLOCK;
+		uint8_t status = from.read(address + offset, block, length);
+		if(status) {
+			return status;
+		}
+		bool changed;
+		status = differs(to, address + offset, block, length, &changed);
+		if(!status && changed) {
+			status = to.write(address + offset, block, length);
+			count++;
+		}
+		if(status) {
+			return status;
+		}
+	}
+	if(copied) {
+		*copied = count;
+	}
+	return 0;
+}
+
+///<summary>
+///	Make [address, address + size) of "to" identical to the host buffer "image", only writing the blocks that differ.
+///		The chip is read a chunk at a time and compared with the image.
+///	<param name="image">host copy of the range, image[0] goes to "address"</param>
+///	<param name="copied">when not null, receives the number of blocks written</param>
+///		<returns>same as SerialRAM::write()</returns>
+///</summary>
+uint8_t SerialRAMSync::sync(const uint8_t* image, SerialRAM& to, const uint16_t address, const uint16_t size, uint16_t* copied) {
+	uint16_t count = 0;
+	for(uint16_t offset = 0; offset < size; offset += SERIALRAM_SYNC_BLOCK) {
+		uint16_t length = size - offset < SERIALRAM_SYNC_BLOCK ? size - offset : SERIALRAM_SYNC_BLOCK;
+		bool changed;
+		uint8_t status = differs(to, address + offset, image + offset, length, &changed);
+		if(!status && changed) {
+			status = to.write(address + offset, image + offset, length);
+			count++;
+		}
+		if(status) {
+			return status;
+		}
+	}
+	if(copied) {
+		*copied = count;
+	}
+	return 0;
+}
+
+///<summary>
+///	Make [address, address + size) of "to" identical to the host buffer "image" without reading the chip:
+///	"hashes" describes what the chip holds, as returned by hash() or left by the previous call, and only the blocks
+///	whose hash in the image differs are written. The hashes of the written blocks are updated.
+///		Blocks that differ with equal CRC-16 (1 in 65536) are missed, use the overload without hashes when that matters.
+///	<param name="image">host copy of the range, image[0] goes to "address"</param>
+///	<param name="hashes">SERIALRAM_SYNC_BLOCKS(size) hashes of the chip contents</param>
+///	<param name="copied">when not null, receives the number of blocks written</param>
+///		<returns>same as SerialRAM::write()</returns>
+///</summary>
+uint8_t SerialRAMSync::sync(const uint8_t* image, SerialRAM& to, const uint16_t address, const uint16_t size, uint16_t* hashes, uint16_t* copied) {
+	uint16_t count = 0;
+	for(uint16_t offset = 0; offset < size; offset += SERIALRAM_SYNC_BLOCK) {
+		uint16_t length = size - offset < SERIALRAM_SYNC_BLOCK ? size - offset : SERIALRAM_SYNC_BLOCK;
+		uint16_t hash = serialRAMCrc16(image + offset, length);
+		if(hash == hashes[offset / SERIALRAM_SYNC_BLOCK]) {
+			continue;
+		}
+		uint8_t status = to.write(address + offset, image + offset, length);
+		if(status) {
+			return status;
+		}
+		hashes[offset / SERIALRAM_SYNC_BLOCK] = hash;
+		count++;
+	}
+	if(copied) {
+		*copied = count;
+	}
+	return 0;
+}
+
+uint8_t SerialRAMSync::hashBlock(SerialRAM& ram, const uint16_t address, const uint16_t size, uint16_t* hash) {
+	uint8_t chunk[SERIALRAM_CHUNK_SIZE];
+	uint16_t crc = 0xffff;
+	for(uint16_t offset = 0; offset < size; offset += SERIALRAM_CHUNK_SIZE) {
+		uint16_t length = size - offset < SERIALRAM_CHUNK_SIZE ? size - offset : SERIALRAM_CHUNK_SIZE;
+		uint8_t status = ram.read(address + offset, chunk, length);
+		if(status) {
+			return status;
+		}
+		crc = serialRAMCrc16(chunk, length, crc);
+	}
+	*hash = crc;
+	return 0;
+}
+
+//Compare the chip with "values" a chunk at a time, stopping at the first chunk that differs
+uint8_t SerialRAMSync::differs(SerialRAM& ram, const uint16_t address, const uint8_t* values, const uint16_t size, bool* result) {
+	uint8_t chunk[SERIALRAM_CHUNK_SIZE];
+	*result = false;
+	for(uint16_t offset = 0; offset < size; offset += SERIALRAM_CHUNK_SIZE) {
+		uint16_t length = size - offset < SERIALRAM_CHUNK_SIZE ? size - offset : SERIALRAM_CHUNK_SIZE;
+		uint8_t status = ram.read(address + offset, chunk, length);
+		if(status) {
+			return status;
+		}
+		if(memcmp(chunk, values + offset, length)) {
+			*result = true;
+			return 0;
+		}
+	}
+	return 0;
+}
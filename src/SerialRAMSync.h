@@ -0,0 +1,35 @@
+/*
+	SerialRAMSync.h
+	Differential copy between two SerialRAM chips, or from a host image to a chip, transferring only the blocks that differ
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#ifndef _SerialRAMSync_h
+#define _SerialRAMSync_h
+
+#include "SerialRAM.h"
+
+//Size of a compared block in bytes
+#ifndef SERIALRAM_SYNC_BLOCK
+	#define SERIALRAM_SYNC_BLOCK 64
+#endif
+
+//Number of hashes needed for a range of "size" bytes
+#define SERIALRAM_SYNC_BLOCKS(size) (((size) + SERIALRAM_SYNC_BLOCK - 1) / SERIALRAM_SYNC_BLOCK)
+
+class SerialRAMSync {
+private:
+	static uint8_t hashBlock(SerialRAM& ram, const uint16_t address, const uint16_t size, uint16_t* hash);
+	static uint8_t differs(SerialRAM& ram, const uint16_t address, const uint8_t* values, const uint16_t size, bool* result);
+
+public:
+	static uint8_t hash(SerialRAM& ram, const uint16_t address, const uint16_t size, uint16_t* hashes);
+	static uint8_t sync(SerialRAM& from, SerialRAM& to, const uint16_t address, const uint16_t size, uint16_t* copied = 0);
+	static uint8_t sync(const uint8_t* image, SerialRAM& to, const uint16_t address, const uint16_t size, uint16_t* copied = 0);
+	static uint8_t sync(const uint8_t* image, SerialRAM& to, const uint16_t address, const uint16_t size, uint16_t* hashes, uint16_t* copied);
+};
+
+#endif
@@ -0,0 +1,239 @@
+/*
+	SerialRAMTier.cpp
+	Two tier storage: frequently accessed regions of a SerialRAM chip are promoted to host RAM and written back periodically
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#include <stdint.h>
+#include "SerialRAMTier.h"
+
+#define NO_REGION 0xffff
+
+
+///<summary>
+///	Manage the device range [address, address + size) in SERIALRAM_TIER_REGION sized regions.
+///		Every access to a region counts. Once a region reaches SERIALRAM_TIER_PROMOTE accesses it is copied
+///		to one of the SERIALRAM_TIER_SLOTS host slots, and later reads and writes to it do not touch the bus.
+///		Writes to a promoted region stay in host RAM until flush() or demotion. tick(), called periodically,
+///		halves the counters so that the tier follows the current access pattern, and demotes the regions
+///		that have cooled down below SERIALRAM_TIER_DEMOTE.
+///	<param name="ram">initialized SerialRAM chip</param>
+///	<param name="address">16 bit address of the managed range</param>
+///	<param name="size">size of the range in bytes, up to 2048</param>
+///</summary>
+SerialRAMTier::SerialRAMTier(SerialRAM& ram, const uint16_t address, const uint16_t size) {
+	this->ram = &ram;
+	this->address = address;
+	this->size = size > SERIALRAM_TIER_MAX_REGIONS * SERIALRAM_TIER_REGION ? SERIALRAM_TIER_MAX_REGIONS * SERIALRAM_TIER_REGION : size;
+	memset(this->counters, 0, sizeof(this->counters));
+	for(uint8_t i = 0; i < SERIALRAM_TIER_SLOTS; i++) {
+		this->slots[i].region = NO_REGION;
+		this->slots[i].dirty = false;
+	}
+	this->resetStatistics();
+}
+
+///<summary>
+///	Read "size" bytes starting at the chip address "address", from host RAM for the promoted regions.
+///		<returns>0:success, 1-4 : same as SerialRAM::read(), 5 : range outside the managed range</returns>
+///</summary>
+uint8_t SerialRAMTier::read(const uint16_t address, uint8_t* values, const uint16_t size) {
+	return this->access(address, values, size, false);
+}
+
+///<summary>
+///	Write "size" bytes starting at the chip address "address". Bytes of promoted regions are only written to host RAM.
+///		<returns>0:success, 1-4 : same as SerialRAM::write(), 5 : range outside the managed range</returns>
+///</summary>
+uint8_t SerialRAMTier::write(const uint16_t address, const uint8_t* values, const uint16_t size) {
+	return this->access(address, (uint8_t*)values, size, true);
+}
+
+///<summary>
+///	Write every modified host slot back to the chip. Regions stay promoted.
+///		<returns>same as SerialRAM::write()</returns>
+///</summary>
+uint8_t SerialRAMTier::flush() {
+	for(uint8_t i = 0; i < SERIALRAM_TIER_SLOTS; i++) {
+		uint8_t status = this->writeBack(&this->slots[i]);
+		if(status) {
+			return status;
+		}
+	}
+	return 0;
+}
+
+///<summary>
+///	Age the access counters and demote the promoted regions that became cold. Call it periodically, e.g. every second.
+///		<returns>same as SerialRAM::write()</returns>
+///</summary>
+uint8_t SerialRAMTier::tick() {
+	uint16_t regions = (this->size + SERIALRAM_TIER_REGION - 1) / SERIALRAM_TIER_REGION;
+	for(uint16_t i = 0; i < regions; i++) {
+		this->counters[i] >>= 1;
+	}
+	for(uint8_t i = 0; i < SERIALRAM_TIER_SLOTS; i++) {
+		slot* s = &this->slots[i];
+		if(s->region != NO_REGION && this->counters[s->region] < SERIALRAM_TIER_DEMOTE) {
+			uint8_t status = this->demote(s);
+			if(status) {
+				return status;
+			}
+		}
+	}
+	return 0;
+}
+
+///<summary>
+///	Whether the region holding the chip address "address" lives in host RAM.
+///</summary>
+bool SerialRAMTier::isResident(const uint16_t address) {
+	if(address < this->address || address - this->address >= this->size) {
+		return false;
+	}
+	return this->lookup((address - this->address) / SERIALRAM_TIER_REGION) != 0;
+}
+
+///<summary>
+///	Number of regions currently promoted to host RAM.
+///</summary>
+uint8_t SerialRAMTier::residentCount() {
+	uint8_t count = 0;
+	for(uint8_t i = 0; i < SERIALRAM_TIER_SLOTS; i++) {
+		if(this->slots[i].region != NO_REGION) {
+			count++;
+		}
+	}
+	return count;
+}
+
+///<summary>
+///	Counters since construction or the last resetStatistics().
+///		Hits are region accesses served from host RAM, misses the accesses that went to the chip.
+///</summary>
+SerialRAMTierStats SerialRAMTier::getStatistics() {
+	return this->stats;
+}
+
+void SerialRAMTier::resetStatistics() {
+	memset(&this->stats, 0, sizeof(this->stats));
+}
+
+SerialRAMTier::slot* SerialRAMTier::lookup(const uint16_t region) {
+	for(uint8_t i = 0; i < SERIALRAM_TIER_SLOTS; i++) {
+		if(this->slots[i].region == region) {
+			return &this->slots[i];
+		}
+	}
+	return 0;
+}
+
+//Bring "region" into host RAM when a slot is free or when the coldest promoted region is colder than it.
+//*result stays null when the region is not promoted.
+uint8_t SerialRAMTier::promote(const uint16_t region, slot** result) {
+	*result = 0;
+	slot* victim = 0;
+	for(uint8_t i = 0; i < SERIALRAM_TIER_SLOTS; i++) {
+		slot* s = &this->slots[i];
+		if(s->region == NO_REGION) {
+			victim = s;
+			break;
+		}
+		if(!victim || this->counters[s->region] < this->counters[victim->region]) {
+			victim = s;
+		}
+	}
+	if(victim->region != NO_REGION) {
+		if(this->counters[victim->region] >= this->counters[region]) {
+			return 0;
+		}
+		uint8_t status = this->demote(victim);
+		if(status) {
+			return status;
+		}
+	}
+	uint16_t offset = region * SERIALRAM_TIER_REGION;
+	uint16_t length = this->size - offset < SERIALRAM_TIER_REGION ? this->size - offset : SERIALRAM_TIER_REGION;
+	uint8_t status = this->ram->read(this->address + offset, victim->data, length);
+	if(status) {
+		return status;
+	}
+	victim->region = region;
+	victim->dirty = false;
+	this->stats.promotions++;
+	*result = victim;
+	return 0;
+}
+
+uint8_t SerialRAMTier::demote(slot* s) {
+	uint8_t status = this->writeBack(s);
+	if(status) {
+		return status;
+	}
+	s->region = NO_REGION;
+	this->stats.demotions++;
+	return 0;
+}
+
+uint8_t SerialRAMTier::writeBack(slot* s) {
+	if(s->region == NO_REGION || !s->dirty) {
+		return 0;
+	}
+	uint16_t offset = s->region * SERIALRAM_TIER_REGION;
+	uint16_t length = this->size - offset < SERIALRAM_TIER_REGION ? this->size - offset : SERIALRAM_TIER_REGION;
+	uint8_t status = this->ram->write(this->address + offset, s->data, length);
+	if(status) {
+		return status;
+	}
+	s->dirty = false;
+	this->stats.writeBacks++;
+	return 0;
+}
+
+uint8_t SerialRAMTier::access(const uint16_t address, uint8_t* values, const uint16_t size, const bool write) {
+	if(address < this->address || size > this->size || address - this->address > this->size - size) {
+		return 5;
+	}
+	uint16_t offset = address - this->address;
+	uint16_t done = 0;
+	while(done < size) {
+		uint16_t region = (offset + done) / SERIALRAM_TIER_REGION;
+		uint16_t start = (offset + done) % SERIALRAM_TIER_REGION;
+		uint16_t length = SERIALRAM_TIER_REGION - start;
+		if(length > size - done) {
+			length = size - done;
+		}
+		if(this->counters[region] < 0xff) {
+			this->counters[region]++;
+		}
+		slot* s = this->lookup(region);
+		if(!s && this->counters[region] >= SERIALRAM_TIER_PROMOTE) {
+			uint8_t status = this->promote(region, &s);
+			if(status) {
+				return status;
+			}
+		}
+		if(s) {
+			if(write) {
+				memcpy(s->data + start, values + done, length);
+				s->dirty = true;
+			}
+			else {
+				memcpy(values + done, s->data + start, length);
+			}
+			this->stats.hits++;
+		}
+		else {
+			uint8_t status = write ? this->ram->write(address + done, values + done, length) : this->ram->read(address + done, values + done, length);
+			if(status) {
+				return status;
+			}
+			this->stats.misses++;
+		}
+		done += length;
+	}
+	return 0;
+}
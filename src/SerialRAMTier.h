@@ -0,0 +1,100 @@
+/*
+	SerialRAMTier.h
+	Two tier storage: frequently accessed regions of a SerialRAM chip are promoted to host RAM and written back periodically
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#ifndef _SerialRAMTier_h
+#define _SerialRAMTier_h
+
+#include "SerialRAM.h"
+
+//Size of a tracked region in bytes
+#ifndef SERIALRAM_TIER_REGION
+	#define SERIALRAM_TIER_REGION SERIALRAM_CHUNK_SIZE
+#endif
+
+//Number of regions held in host RAM, the RAM budget is SERIALRAM_TIER_SLOTS * SERIALRAM_TIER_REGION bytes
+#ifndef SERIALRAM_TIER_SLOTS
+	#define SERIALRAM_TIER_SLOTS 4
+#endif
+
+//Access count from which a region is promoted
+#ifndef SERIALRAM_TIER_PROMOTE
+	#define SERIALRAM_TIER_PROMOTE 8
+#endif
+
+//Access count under which a promoted region is demoted by tick()
+#ifndef SERIALRAM_TIER_DEMOTE
+	#define SERIALRAM_TIER_DEMOTE 2
+#endif
+
+//Largest number of regions tracked, enough for a whole 47x16 chip
+#define SERIALRAM_TIER_MAX_REGIONS (2048 / SERIALRAM_TIER_REGION)
+
+typedef struct {
+	uint32_t hits;
+	uint32_t misses;
+	uint32_t promotions;
+	uint32_t demotions;
+	uint32_t writeBacks;
+} SerialRAMTierStats;
+
+class SerialRAMTier {
+private:
+	typedef struct {
+		uint16_t region;
+		bool dirty;
+		uint8_t data[SERIALRAM_TIER_REGION];
+	} slot;
+
+	SerialRAM* ram;
+	uint16_t address;
+	uint16_t size;
+	uint8_t counters[SERIALRAM_TIER_MAX_REGIONS];
+	slot slots[SERIALRAM_TIER_SLOTS];
+	SerialRAMTierStats stats;
+
+	slot* lookup(const uint16_t region);
+	uint8_t promote(const uint16_t region, slot** result);
+	uint8_t demote(slot* s);
+	uint8_t writeBack(slot* s);
+	uint8_t access(const uint16_t address, uint8_t* values, const uint16_t size, const bool write);
+
+public:
+	SerialRAMTier(SerialRAM& ram, const uint16_t address, const uint16_t size);
+
+	uint8_t read(const uint16_t address, uint8_t* values, const uint16_t size);
+	uint8_t write(const uint16_t address, const uint8_t* values, const uint16_t size);
+
+	///<summary>
+	///	Read a value of type T at the chip address "address"
+	///		<returns>same as read()</returns>
+	///</summary>
+	template<typename T>
+	uint8_t get(const uint16_t address, T* value) {
+		return this->read(address, (uint8_t*)value, sizeof(T));
+	}
+
+	///<summary>
+	///	Write a value of type T at the chip address "address"
+	///		<returns>same as write()</returns>
+	///</summary>
+	template<typename T>
+	uint8_t put(const uint16_t address, const T& value) {
+		return this->write(address, (const uint8_t*)&value, sizeof(T));
+	}
+
+	uint8_t flush();
+	uint8_t tick();
+	bool isResident(const uint16_t address);
+	uint8_t residentCount();
+
+	SerialRAMTierStats getStatistics();
+	void resetStatistics();
+};
+
+#endif
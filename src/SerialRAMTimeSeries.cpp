@@ -0,0 +1,241 @@
+/*
+	SerialRAMTimeSeries.cpp
+	Append only time series store with delta encoded blocks and a per block time index
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#include <stdint.h>
+#include "SerialRAMTimeSeries.h"
+#include "SerialRAMCompress.h"
+
+
+///<summary>
+///	Create a time series store in the device range [address, address + size).
+///		The range holds an index of SERIALRAM_TS_INDEX_SIZE bytes per block followed by the blocks themselves.
+///		When all blocks are used the oldest one is overwritten.
+///	<param name="ram">initialized SerialRAM chip</param>
+///	<param name="address">16 bit address of the store</param>
+///	<param name="size">size of the store in bytes</param>
+///</summary>
+SerialRAMTimeSeries::SerialRAMTimeSeries(SerialRAM& ram, const uint16_t address, const uint16_t size) {
+	this->ram = &ram;
+	this->address = address;
+	uint16_t blocks = size / (SERIALRAM_TS_BLOCK_SIZE + SERIALRAM_TS_INDEX_SIZE);
+	this->blocks = blocks > 0xff ? 0xff : blocks;
+	this->head = 0;
+	this->used = 0;
+	this->count = 0;
+	this->written = false;
+}
+
+///<summary>
+///	Find the newest block from the index and start appending in the block after it.
+///		<returns>same as SerialRAM::read()</returns>
+///</summary>
+uint8_t SerialRAMTimeSeries::begin() {
+	uint32_t newest = 0;
+	bool found = false;
+	this->head = 0;
+	this->used = 0;
+	this->count = 0;
+	this->written = false;
+	for(uint8_t i = 0; i < this->blocks; i++) {
+		uint32_t first, last;
+		uint8_t length, samples;
+		uint8_t status = this->readIndex(i, &first, &last, &length, &samples);
+		if(status) {
+			return status;
+		}
+		if(samples && (!found || last >= newest)) {
+			newest = last;
+			found = true;
+			this->head = (i + 1) % this->blocks;
+		}
+	}
+	return 0;
+}
+
+///<summary>
+///	Drop every sample, on the chip and in the pending block.
+///		<returns>same as SerialRAM::write()</returns>
+///</summary>
+uint8_t SerialRAMTimeSeries::clear() {
+	this->head = 0;
+	this->used = 0;
+	this->count = 0;
+	this->written = false;
+	return this->ram->fill(this->address, 0, (uint16_t)this->blocks * SERIALRAM_TS_INDEX_SIZE);
+}
+
+///<summary>
+///	Append a sample. Times must not decrease. Samples are encoded in the host block buffer,
+///	which is written with one bulk write when it is full or when flush() is called.
+///		<param name="time">timestamp of the sample, for instance millis()</param>
+///		<param name="value">value of the sample</param>
+///		<returns>0:success, 1-4 : same as SerialRAM::write(), 5 : the store has no block</returns>
+///</summary>
+uint8_t SerialRAMTimeSeries::append(const uint32_t time, const int32_t value) {
+	if(!this->blocks) {
+		return 5;
+	}
+	uint8_t encoded[2 * SERIALRAM_VARINT_MAX];
+	uint8_t n = 0;
+	if(this->count) {
+		n = SerialRAMCompressor::encode(encoded, (int32_t)(time - this->lastTime));
+		n += SerialRAMCompressor::encode(encoded + n, (int32_t)((uint32_t)value - (uint32_t)this->lastValue));
+	}
+	if(this->count == 0xff || this->used + n > SERIALRAM_TS_BLOCK_SIZE) {
+		uint8_t status = this->flush();
+		if(status) {
+			return status;
+		}
+		this->head = (this->head + 1) % this->blocks;
+		this->used = 0;
+		this->count = 0;
+		this->written = false;
+	}
+	if(!this->count) {
+		//first sample of a block is stored as absolute values
+		n = SerialRAMCompressor::encode(encoded, (int32_t)time);
+		n += SerialRAMCompressor::encode(encoded + n, value);
+		this->firstTime = time;
+	}
+	memcpy(this->block + this->used, encoded, n);
+	this->used += n;
+	this->count++;
+	this->lastTime = time;
+	this->lastValue = value;
+	return 0;
+}
+
+///<summary>
+///	Write the pending block and its index entry to the chip. Appending can continue in the same block afterwards.
+///		<returns>same as SerialRAM::write()</returns>
+///</summary>
+uint8_t SerialRAMTimeSeries::flush() {
+	if(!this->count) {
+		return 0;
+	}
+	uint8_t entry[SERIALRAM_TS_INDEX_SIZE];
+	uint16_t index = this->indexAddress(this->head);
+	uint8_t status = 0;
+	if(!this->written) {
+		//the block may still describe overwritten samples: invalidate it before its data changes
+		status = this->ram->write(index + 9, (uint8_t)0);
+	}
+	if(!status) {
+		status = this->ram->write(this->blockAddress(this->head), this->block, this->used);
+	}
+	if(status) {
+		return status;
+	}
+	for(uint8_t i = 0; i < 4; i++) {
+		entry[i] = this->firstTime >> (8 * i);
+		entry[4 + i] = this->lastTime >> (8 * i);
+	}
+	entry[8] = this->used;
+	entry[9] = this->count;
+	status = this->ram->write(index, entry, SERIALRAM_TS_INDEX_SIZE);
+	this->written = !status;
+	return status;
+}
+
+///<summary>
+///	Call "callback" for every sample with from <= time <= to, oldest first.
+///		Only the index and the blocks whose time span overlaps the range are read from the chip.
+///		<param name="from">first time of the range</param>
+///		<param name="to">last time of the range</param>
+///		<param name="callback">function called for each matching sample</param>
+///		<param name="context">pointer given back to callback</param>
+///		<returns>number of matching samples</returns>
+///</summary>
+uint16_t SerialRAMTimeSeries::query(const uint32_t from, const uint32_t to, SerialRAMSampleCallback callback, void* context) {
+	uint8_t data[SERIALRAM_TS_BLOCK_SIZE];
+	uint16_t matches = 0;
+	//with a pending block the head is the newest block and lives in host RAM, otherwise it is the oldest one
+	uint8_t first = this->count ? 1 : 0;
+	for(uint8_t i = first; i < this->blocks; i++) {
+		uint8_t b = (this->head + i) % this->blocks;
+		uint32_t start, end;
+		uint8_t length, samples;
+		if(this->readIndex(b, &start, &end, &length, &samples) || !samples) {
+			continue;
+		}
+		if(end < from || start > to || length > SERIALRAM_TS_BLOCK_SIZE) {
+			continue;
+		}
+		if(this->ram->read(this->blockAddress(b), data, length)) {
+			continue;
+		}
+		matches += this->decode(data, length, from, to, callback, context);
+	}
+	if(this->count && this->lastTime >= from && this->firstTime <= to) {
+		matches += this->decode(this->block, this->used, from, to, callback, context);
+	}
+	return matches;
+}
+
+///<summary>
+///	Number of blocks that fit in the range given to the constructor.
+///</summary>
+uint8_t SerialRAMTimeSeries::blockCount() {
+	return this->blocks;
+}
+
+uint16_t SerialRAMTimeSeries::indexAddress(const uint8_t block) {
+	return this->address + (uint16_t)block * SERIALRAM_TS_INDEX_SIZE;
+}
+
+uint16_t SerialRAMTimeSeries::blockAddress(const uint8_t block) {
+	return this->indexAddress(this->blocks) + (uint16_t)block * SERIALRAM_TS_BLOCK_SIZE;
+}
+
+uint8_t SerialRAMTimeSeries::readIndex(const uint8_t block, uint32_t* first, uint32_t* last, uint8_t* length, uint8_t* samples) {
+	uint8_t entry[SERIALRAM_TS_INDEX_SIZE];
+	uint8_t status = this->ram->read(this->indexAddress(block), entry, SERIALRAM_TS_INDEX_SIZE);
+	if(status) {
+		return status;
+	}
+	*first = 0;
+	*last = 0;
+	for(uint8_t i = 0; i < 4; i++) {
+		*first |= (uint32_t)entry[i] << (8 * i);
+		*last |= (uint32_t)entry[4 + i] << (8 * i);
+	}
+	*length = entry[8];
+	*samples = entry[9];
+	return 0;
+}
+
+uint16_t SerialRAMTimeSeries::decode(const uint8_t* data, const uint8_t length, const uint32_t from, const uint32_t to, SerialRAMSampleCallback callback, void* context) {
+	uint16_t matches = 0;
+	uint32_t time = 0;
+	uint32_t value = 0;
+	uint8_t position = 0;
+	while(position < length) {
+		int32_t dt, dv;
+		uint8_t n = SerialRAMCompressor::decode(data + position, length - position, &dt);
+		if(!n) {
+			break;
+		}
+		position += n;
+		n = SerialRAMCompressor::decode(data + position, length - position, &dv);
+		if(!n) {
+			break;
+		}
+		position += n;
+		time += (uint32_t)dt;
+		value += (uint32_t)dv;
+		if(time > to) {
+			break;
+		}
+		if(time >= from) {
+			callback(time, (int32_t)value, context);
+			matches++;
+		}
+	}
+	return matches;
+}
@@ -0,0 +1,55 @@
+/*
+	SerialRAMTimeSeries.h
+	Append only time series store with delta encoded blocks and a per block time index
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#ifndef _SerialRAMTimeSeries_h
+#define _SerialRAMTimeSeries_h
+
+#include "SerialRAM.h"
+
+//Size in bytes of an encoded block. One block is buffered in host RAM while it fills.
+#ifndef SERIALRAM_TS_BLOCK_SIZE
+	#define SERIALRAM_TS_BLOCK_SIZE 64
+#endif
+
+//Index entry: first time (4), last time (4), encoded length (1), sample count (1)
+#define SERIALRAM_TS_INDEX_SIZE 10
+
+typedef void (*SerialRAMSampleCallback)(const uint32_t time, const int32_t value, void* context);
+
+class SerialRAMTimeSeries {
+private:
+	SerialRAM* ram;
+	uint16_t address;
+	uint8_t blocks;
+	uint8_t head;
+	uint8_t block[SERIALRAM_TS_BLOCK_SIZE];
+	uint8_t used;
+	uint8_t count;
+	bool written;
+	uint32_t firstTime;
+	uint32_t lastTime;
+	int32_t lastValue;
+
+	uint16_t indexAddress(const uint8_t block);
+	uint16_t blockAddress(const uint8_t block);
+	uint8_t readIndex(const uint8_t block, uint32_t* first, uint32_t* last, uint8_t* length, uint8_t* samples);
+	uint16_t decode(const uint8_t* data, const uint8_t length, const uint32_t from, const uint32_t to, SerialRAMSampleCallback callback, void* context);
+
+public:
+	SerialRAMTimeSeries(SerialRAM& ram, const uint16_t address, const uint16_t size);
+
+	uint8_t begin();
+	uint8_t clear();
+	uint8_t append(const uint32_t time, const int32_t value);
+	uint8_t flush();
+	uint16_t query(const uint32_t from, const uint32_t to, SerialRAMSampleCallback callback, void* context = 0);
+	uint8_t blockCount();
+};
+
+#endif
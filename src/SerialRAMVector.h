@@ -0,0 +1,166 @@
+/*
+	SerialRAMVector.h
+	Persistent vector of fixed size elements stored in a region of a SerialRAM chip
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#ifndef _SerialRAMVector_h
+#define _SerialRAMVector_h
+
+#include "SerialRAM.h"
+
+//Size in bytes of the header in front of the elements: element count (2)
+#define SERIALRAM_VECTOR_HEADER_SIZE 2
+
+//Elements are stored as their raw bytes: T must be trivially copyable
+template<typename T>
+class SerialRAMVector {
+private:
+	SerialRAM* ram;
+	uint16_t address;
+	uint16_t slots;
+	uint16_t count;
+
+	uint16_t elementAddress(const uint16_t index) {
+		return this->address + SERIALRAM_VECTOR_HEADER_SIZE + index * sizeof(T);
+	}
+
+	uint8_t writeHeader(const uint16_t count) {
+		uint8_t header[SERIALRAM_VECTOR_HEADER_SIZE] = { (uint8_t)(count & 0xff), (uint8_t)(count >> 8) };
+		uint8_t status = this->ram->write(this->address, header, SERIALRAM_VECTOR_HEADER_SIZE);
+		if(!status) {
+			this->count = count;
+		}
+		return status;
+	}
+
+public:
+	///<summary>
+	///	Create a vector in the device range [address, address + size). The capacity is fixed by the size of the range.
+	///	<param name="ram">initialized SerialRAM chip</param>
+	///	<param name="address">16 bit address of the vector header</param>
+	///	<param name="size">size of the range in bytes, header included</param>
+	///</summary>
+	SerialRAMVector(SerialRAM& ram, const uint16_t address, const uint16_t size) {
+		this->ram = &ram;
+		this->address = address;
+		this->slots = size > SERIALRAM_VECTOR_HEADER_SIZE ? (size - SERIALRAM_VECTOR_HEADER_SIZE) / sizeof(T) : 0;
+		this->count = 0;
+	}
+
+	///<summary>
+	///	Load the element count from the chip. A count larger than the capacity is treated as an empty vector.
+	///		<returns>same as SerialRAM::read()</returns>
+	///</summary>
+	uint8_t begin() {
+		uint8_t header[SERIALRAM_VECTOR_HEADER_SIZE];
+		uint8_t status = this->ram->read(this->address, header, SERIALRAM_VECTOR_HEADER_SIZE);
+		if(status) {
+			return status;
+		}
+		uint16_t stored = header[0] | (header[1] << 8);
+		this->count = stored > this->slots ? 0 : stored;
+		return 0;
+	}
+
+	uint16_t size() {
+		return this->count;
+	}
+
+	uint16_t capacity() {
+		return this->slots;
+	}
+
+	bool empty() {
+		return this->count == 0;
+	}
+
+	///<summary>
+	///	Check that "n" elements fit in the region. The region is fixed, so nothing is allocated.
+	///		<returns>0 if n elements fit, 5 otherwise</returns>
+	///</summary>
+	uint8_t reserve(const uint16_t n) {
+		return n <= this->slots ? 0 : 5;
+	}
+
+	uint8_t push_back(const T& value) {
+		return this->push_back(&value, 1);
+	}
+
+	///<summary>
+	///	Append "n" elements. The data is written with one bulk write (split in SERIALRAM_CHUNK_SIZE transactions)
+	///	before a single header write, so a reset in between leaves the previous size intact.
+	///		<returns>0:success, 1-4 : same as SerialRAM::write(), 5 : not enough room, nothing written</returns>
+	///</summary>
+	uint8_t push_back(const T* values, const uint16_t n) {
+		if(n > this->slots - this->count) {
+			return 5;
+		}
+		uint8_t status = this->ram->write(this->elementAddress(this->count), (const uint8_t*)values, n * sizeof(T));
+		if(status) {
+			return status;
+		}
+		return this->writeHeader(this->count + n);
+	}
+
+	///<summary>
+	///	Remove the last element.
+	///		<returns>0:success, 1-4 : same as SerialRAM::write(), 5 : vector empty</returns>
+	///</summary>
+	uint8_t pop_back() {
+		if(!this->count) {
+			return 5;
+		}
+		return this->writeHeader(this->count - 1);
+	}
+
+	uint8_t clear() {
+		return this->writeHeader(0);
+	}
+
+	///<summary>
+	///	Copy the element at "index" into "value".
+	///		<returns>0:success, 1-4 : same as SerialRAM::read(), 5 : index out of bounds</returns>
+	///</summary>
+	uint8_t get(const uint16_t index, T* value) {
+		return this->read(index, value, 1);
+	}
+
+	///<summary>
+	///	Element at "index", or a zeroed element if it cannot be read.
+	///</summary>
+	T at(const uint16_t index) {
+		T value;
+		if(this->get(index, &value)) {
+			memset(&value, 0, sizeof(T));
+		}
+		return value;
+	}
+
+	///<summary>
+	///	Replace the element at "index".
+	///		<returns>0:success, 1-4 : same as SerialRAM::write(), 5 : index out of bounds</returns>
+	///</summary>
+	uint8_t set(const uint16_t index, const T& value) {
+		if(index >= this->count) {
+			return 5;
+		}
+		return this->ram->write(this->elementAddress(index), (const uint8_t*)&value, sizeof(T));
+	}
+
+	///<summary>
+	///	Copy "n" elements starting at "first" into "values" with one bulk read.
+	///		<returns>0:success, 1-4 : same as SerialRAM::read(), 5 : range out of bounds</returns>
+	///</summary>
+	uint8_t read(const uint16_t first, T* values, const uint16_t n) {
+		if(first > this->count || n > this->count - first) {
+			return 5;
+		}
+		return this->ram->read(this->elementAddress(first), (uint8_t*)values, n * sizeof(T));
+	}
+};
+
+#endif
@@ -0,0 +1,135 @@
+/*
+	SerialRAMWriteQueue.cpp
+	Lock free single producer / single consumer queue of deferred writes, filled from interrupt handlers
+	and drained to a SerialRAM chip from the main loop
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#include <stdint.h>
+#include "SerialRAMWriteQueue.h"
+
+#define QUEUE_MASK (SERIALRAM_QUEUE_DEPTH - 1)
+
+
+///<summary>
+///	Create an empty queue of writes to "ram".
+///		One context (typically an ISR) calls push(), one other (typically loop()) calls drain().
+///	<param name="ram">initialized SerialRAM chip</param>
+///</summary>
+SerialRAMWriteQueue::SerialRAMWriteQueue(SerialRAM& ram) {
+	this->ram = &ram;
+	this->head = 0;
+	this->tail = 0;
+	this->overflows = 0;
+	this->highWater = 0;
+}
+
+///<summary>
+///	Queue a write of "size" bytes at "address". Safe to call from an interrupt handler: it only copies
+///	the bytes into the next free record and publishes it, it never touches the bus.
+///		<param name="address">16 bit address</param>
+///		<param name="values">bytes to write, copied into the queue</param>
+///		<param name="size">number of bytes, up to SERIALRAM_QUEUE_RECORD_SIZE</param>
+///		<returns>true if queued, false if the queue is full (counted as an overflow) or size is too large</returns>
+///</summary>
+bool SerialRAMWriteQueue::push(const uint16_t address, const uint8_t* values, const uint8_t size) {
+	if(size > SERIALRAM_QUEUE_RECORD_SIZE) {
+		return false;
+	}
+	uint8_t head = this->head;
+	uint8_t used = (uint8_t)(head - __atomic_load_n(&this->tail, __ATOMIC_ACQUIRE));
+	if(used >= SERIALRAM_QUEUE_DEPTH) {
+		if(this->overflows != 0xffff) {
+			this->overflows = this->overflows + 1;
+		}
+		return false;
+	}
+	record* r = &this->records[head & QUEUE_MASK];
+	r->address = address;
+	r->size = size;
+	memcpy(r->data, values, size);
+	__atomic_store_n(&this->head, (uint8_t)(head + 1), __ATOMIC_RELEASE);
+	if(used + 1 > this->highWater) {
+		this->highWater = used + 1;
+	}
+	return true;
+}
+
+///<summary>
+///	Queue a single byte write, see push(address, values, size).
+///</summary>
+bool SerialRAMWriteQueue::push(const uint16_t address, const uint8_t value) {
+	return this->push(address, &value, 1);
+}
+
+///<summary>
+///	Write queued records to the chip, in order. Records whose addresses follow each other are merged into
+///	one bulk transfer of up to SERIALRAM_CHUNK_SIZE bytes. Call it from the main loop only.
+///		<param name="maxWrites">largest number of bus transfers to issue, to bound the time spent</param>
+///		<returns>same as SerialRAM::write(). Records that could not be written stay queued.</returns>
+///</summary>
+uint8_t SerialRAMWriteQueue::drain(const uint8_t maxWrites) {
+	uint8_t buffer[SERIALRAM_CHUNK_SIZE];
+	for(uint8_t writes = 0; writes < maxWrites; writes++) {
+		uint8_t tail = this->tail;
+		uint8_t head = __atomic_load_n(&this->head, __ATOMIC_ACQUIRE);
+		if(tail == head) {
+			return 0;
+		}
+		uint16_t address = this->records[tail & QUEUE_MASK].address;
+		uint8_t length = 0;
+		uint8_t end = tail;
+		while(end != head) {
+			record* r = &this->records[end & QUEUE_MASK];
+			if(r->address != address + length || length + r->size > SERIALRAM_CHUNK_SIZE) {
+				break;
+			}
+			memcpy(buffer + length, r->data, r->size);
+			length += r->size;
+			end++;
+		}
+		uint8_t status = this->ram->write(address, buffer, length);
+		if(status) {
+			return status;
+		}
+		__atomic_store_n(&this->tail, end, __ATOMIC_RELEASE);
+	}
+	return 0;
+}
+
+///<summary>
+///	Number of records waiting to be written.
+///</summary>
+uint8_t SerialRAMWriteQueue::pending() {
+	return (uint8_t)(__atomic_load_n(&this->head, __ATOMIC_ACQUIRE) - this->tail);
+}
+
+///<summary>
+///	Number of records rejected because the queue was full, saturating at 0xFFFF.
+///</summary>
+uint16_t SerialRAMWriteQueue::getOverflows() {
+	//the producer may update the counter between the two byte reads of an 8 bit core, read until stable
+	uint16_t value;
+	do {
+		value = this->overflows;
+	} while(value != this->overflows);
+	return value;
+}
+
+///<summary>
+///	Largest number of records ever waiting at once. Close to SERIALRAM_QUEUE_DEPTH means drain() should run more often.
+///</summary>
+uint8_t SerialRAMWriteQueue::getHighWater() {
+	return this->highWater;
+}
+
+///<summary>
+///	Reset the overflow counter and the high water mark. Call it with the producer quiet.
+///</summary>
+void SerialRAMWriteQueue::resetStatistics() {
+	this->overflows = 0;
+	this->highWater = 0;
+}
@@ -0,0 +1,59 @@
+/*
+	SerialRAMWriteQueue.h
+	Lock free single producer / single consumer queue of deferred writes, filled from interrupt handlers
+	and drained to a SerialRAM chip from the main loop
+
+	This example code is licensed under CC BY 4.0.
+	Please see https://creativecommons.org/licenses/by/4.0/
+
+*/
+
+#ifndef _SerialRAMWriteQueue_h
+#define _SerialRAMWriteQueue_h
+
+#include "SerialRAM.h"
+
+//Number of records, must be a power of two up to 128
+#ifndef SERIALRAM_QUEUE_DEPTH
+	#define SERIALRAM_QUEUE_DEPTH 16
+#endif
+
+//Largest number of data bytes in one record
+#ifndef SERIALRAM_QUEUE_RECORD_SIZE
+	#define SERIALRAM_QUEUE_RECORD_SIZE 4
+#endif
+
+#if (SERIALRAM_QUEUE_DEPTH & (SERIALRAM_QUEUE_DEPTH - 1)) || SERIALRAM_QUEUE_DEPTH > 128
+	#error "SERIALRAM_QUEUE_DEPTH must be a power of two up to 128"
+#endif
+
+class SerialRAMWriteQueue {
+private:
+	typedef struct {
+		uint16_t address;
+		uint8_t size;
+		uint8_t data[SERIALRAM_QUEUE_RECORD_SIZE];
+	} record;
+
+	SerialRAM* ram;
+	record records[SERIALRAM_QUEUE_DEPTH];
+	//head is only written by the producer, tail only by the consumer
+	volatile uint8_t head;
+	volatile uint8_t tail;
+	volatile uint16_t overflows;
+	volatile uint8_t highWater;
+
+public:
+	SerialRAMWriteQueue(SerialRAM& ram);
+
+	bool push(const uint16_t address, const uint8_t* values, const uint8_t size);
+	bool push(const uint16_t address, const uint8_t value);
+
+	uint8_t drain(const uint8_t maxWrites = 0xff);
+	uint8_t pending();
+	uint16_t getOverflows();
+	uint8_t getHighWater();
+	void resetStatistics();
+};
+
+#endif